@@ -0,0 +1,90 @@
+/**
+ * @file numeric.c
+ * @brief parse_int/parse_double against strtol/strtod over millions of values
+ */
+
+#include "internal_funcs.h"
+#include "bench_timer.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#define VALUE_COUNT 2000000
+#define VALUE_SIZE 32
+
+static unsigned next_random(unsigned* state)
+{
+    *state = *state * 1103515245u + 12345u;
+    return *state >> 1;
+}
+
+static void report(const char* name, uint64_t elapsed, double checksum)
+{
+    printf("%-14s %10.2f ns/value (checksum %g)\n", name, (double)elapsed / VALUE_COUNT, checksum);
+}
+
+int main()
+{
+    char* ints = malloc((size_t)VALUE_COUNT * VALUE_SIZE);
+    char* doubles = malloc((size_t)VALUE_COUNT * VALUE_SIZE);
+    if (!ints || !doubles)
+        return 1;
+
+    unsigned state = 1;
+    for (int i = 0; i < VALUE_COUNT; i++)
+    {
+        int value = (int)next_random(&state) - (1 << 30);
+        snprintf(ints + (size_t)i * VALUE_SIZE, VALUE_SIZE, "%d", value);
+        double real = (double)value / (1 + next_random(&state) % 10000);
+        // mix of short and round-trip precision representations
+        snprintf(doubles + (size_t)i * VALUE_SIZE, VALUE_SIZE, "%.*g", (i & 1) ? 17 : 8, real);
+    }
+
+    uint64_t start;
+    double checksum;
+
+    checksum = 0;
+    start = bench_now_ns();
+    for (int i = 0; i < VALUE_COUNT; i++)
+    {
+        const char* str = ints + (size_t)i * VALUE_SIZE;
+        checksum += strtol(str, NULL, 10);
+    }
+    report("strtol", bench_now_ns() - start, checksum);
+
+    checksum = 0;
+    start = bench_now_ns();
+    for (int i = 0; i < VALUE_COUNT; i++)
+    {
+        const char* str = ints + (size_t)i * VALUE_SIZE;
+        int value = 0;
+        parse_int(str, str + strlen(str), &value);
+        checksum += value;
+    }
+    report("parse_int", bench_now_ns() - start, checksum);
+
+    checksum = 0;
+    start = bench_now_ns();
+    for (int i = 0; i < VALUE_COUNT; i++)
+    {
+        const char* str = doubles + (size_t)i * VALUE_SIZE;
+        checksum += strtod(str, NULL);
+    }
+    report("strtod", bench_now_ns() - start, checksum);
+
+    checksum = 0;
+    start = bench_now_ns();
+    for (int i = 0; i < VALUE_COUNT; i++)
+    {
+        const char* str = doubles + (size_t)i * VALUE_SIZE;
+        double value = 0;
+        parse_double(str, str + strlen(str), &value);
+        checksum += value;
+    }
+    report("parse_double", bench_now_ns() - start, checksum);
+
+    free(doubles);
+    free(ints);
+    return 0;
+}
@@ -0,0 +1,71 @@
+/**
+ * @file scaling.c
+ * @brief Registration and parse time per option for growing schemas,
+ * ns/option should stay flat when both are linear
+ */
+
+#include "argsparse.h"
+#include "bench_timer.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#define NAME_SIZE 32
+
+int main(int argc, char** argv)
+{
+    (void)argc;
+    const int counts[] = { 10, 100, 1000, 10000, 100000 };
+    int max_count = counts[sizeof(counts) / sizeof(counts[0]) - 1];
+
+    char* names = malloc((size_t)max_count * NAME_SIZE);
+    char* tokens = malloc((size_t)max_count * NAME_SIZE);
+    char** args = malloc(((size_t)max_count + 1) * sizeof(char*));
+    if (!names || !tokens || !args)
+        return 1;
+
+    for (int i = 0; i < max_count; i++)
+    {
+        snprintf(names + (size_t)i * NAME_SIZE, NAME_SIZE, "option%d", i);
+        snprintf(tokens + (size_t)i * NAME_SIZE, NAME_SIZE, "--option%d=%d", i, i);
+        args[i + 1] = tokens + (size_t)i * NAME_SIZE;
+    }
+    args[0] = argv[0];
+
+    FILE* out = stdout;
+
+    fprintf(out, "%10s %14s %14s %14s %14s\n", "options", "register ns", "ns/option", "parse ns", "ns/option");
+    for (size_t c = 0; c < sizeof(counts) / sizeof(counts[0]); c++)
+    {
+        int count = counts[c];
+        ARG_DATA_HANDLE handle = argsparse_ctx_create("scaling");
+        // parse diagnostics would dominate the timing
+        argsparse_ctx_set_flags(handle, ARGSPARSE_FLAG_QUIET);
+
+        uint64_t start = bench_now_ns();
+        for (int i = 0; i < count; i++)
+        {
+            argsparse_ctx_add_int(handle, names + (size_t)i * NAME_SIZE, "generated option", 0);
+        }
+        uint64_t registered = bench_now_ns();
+        int parsed = argsparse_ctx_parse_args(handle, args, count + 1);
+        uint64_t done = bench_now_ns();
+
+        if (parsed != count)
+        {
+            fprintf(out, "parsed %d of %d options\n", parsed, count);
+            return 1;
+        }
+
+        fprintf(out, "%10d %14llu %14.1f %14llu %14.1f\n", count,
+            (unsigned long long)(registered - start), (double)(registered - start) / count,
+            (unsigned long long)(done - registered), (double)(done - registered) / count);
+        argsparse_ctx_free(handle);
+    }
+
+    free(args);
+    free(tokens);
+    free(names);
+    return 0;
+}
@@ -0,0 +1,505 @@
+/**
+ * @file suite.c
+ * @brief Registration, parse (also lazy, frozen and from an @file),
+ * configuration file loading, lookup by name, short name and id, usage,
+ * free and schema cache creation over synthetic schemas of 10 to 100k
+ * options, then batch parsing and tokenizing and parsing 200k entries at
+ * every scan level. One JSON object per line and operation:
+ *
+ *     {"op":"parse","options":1000,"threads":1,"ops":100000,"ns_per_op":31.2,"allocs_per_op":0.000,"peak_rss_kb":2048}
+ *
+ * allocs_per_op is null where malloc cannot be wrapped. An optional
+ * argument limits the largest schema.
+ */
+
+#include "argsparse.h"
+#include "bench_timer.h"
+#include "scan.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#if defined(_WIN32)
+#include <psapi.h>
+#else
+#include <sys/resource.h>
+#endif
+
+#define NAME_SIZE 32
+#define RESPONSE_FILE "argsparse-bench.rsp"
+#define CONFIG_FILE "argsparse-bench.ini"
+#define CACHE_FILE "argsparse-bench.cache"
+#define BATCH_SIZE 100000
+#define BATCH_OPTIONS 10
+#define BATCH_MAX_THREADS 16
+/// @brief argv entries of the scan measurements
+#define SCAN_ENTRIES 200000
+#define SCAN_ROUNDS 10
+/// @brief operations per measurement, small schemas are repeated
+#define TARGET_OPS 100000
+
+////////////////////////
+// Allocation counter //
+////////////////////////
+
+static unsigned long long g_allocations = 0;
+
+#if defined(BENCH_COUNT_ALLOCATIONS)
+// linked with -Wl,--wrap so the library calls land here too, also from
+// the parse_batch threads
+void* __real_malloc(size_t size);
+void* __real_calloc(size_t count, size_t size);
+void* __real_realloc(void* ptr, size_t size);
+
+void* __wrap_malloc(size_t size)
+{
+    __atomic_fetch_add(&g_allocations, 1, __ATOMIC_RELAXED);
+    return __real_malloc(size);
+}
+
+void* __wrap_calloc(size_t count, size_t size)
+{
+    __atomic_fetch_add(&g_allocations, 1, __ATOMIC_RELAXED);
+    return __real_calloc(count, size);
+}
+
+void* __wrap_realloc(void* ptr, size_t size)
+{
+    __atomic_fetch_add(&g_allocations, 1, __ATOMIC_RELAXED);
+    return __real_realloc(ptr, size);
+}
+#endif
+
+static long peak_rss_kb()
+{
+#if defined(_WIN32)
+    PROCESS_MEMORY_COUNTERS counters;
+    if (!GetProcessMemoryInfo(GetCurrentProcess(), &counters, sizeof(counters)))
+        return -1;
+    return (long)(counters.PeakWorkingSetSize / 1024);
+#else
+    struct rusage usage;
+    if (getrusage(RUSAGE_SELF, &usage))
+        return -1;
+#if defined(__APPLE__)
+    return (long)(usage.ru_maxrss / 1024);
+#else
+    return (long)usage.ru_maxrss;
+#endif
+#endif
+}
+
+/////////////////
+// Measurement //
+/////////////////
+
+typedef struct _measure
+{
+    uint64_t start_ns;
+    unsigned long long start_allocations;
+} measure_t;
+
+static void measure_start(measure_t* m)
+{
+    m->start_allocations = g_allocations;
+    m->start_ns = bench_now_ns();
+}
+
+static void measure_report(const measure_t* m, const char* op, int options, int threads, unsigned long long ops)
+{
+    uint64_t elapsed = bench_now_ns() - m->start_ns;
+    unsigned long long allocations = g_allocations - m->start_allocations;
+
+    printf("{\"op\":\"%s\",\"options\":%d,\"threads\":%d,\"ops\":%llu,\"ns_per_op\":%.1f,", op, options, threads, ops, (double)elapsed / ops);
+#if defined(BENCH_COUNT_ALLOCATIONS)
+    printf("\"allocs_per_op\":%.3f,", (double)allocations / ops);
+#else
+    (void)allocations;
+    printf("\"allocs_per_op\":null,");
+#endif
+    printf("\"peak_rss_kb\":%ld}\n", peak_rss_kb());
+    fflush(stdout);
+}
+
+static void discard_output(void* context, int stream, const char* text, size_t length)
+{
+    (void)stream;
+    (void)text;
+    *(size_t*)context += length;
+}
+
+typedef struct _schema
+{
+    const char* names;
+    int count;
+} schema_t;
+
+static ARG_ERROR build_schema(ARG_DATA_HANDLE handle, void* context)
+{
+    const schema_t* schema = context;
+    for (int i = 0; i < schema->count; i++)
+    {
+        argsparse_ctx_add_int(handle, schema->names + (size_t)i * NAME_SIZE, "generated option", 0);
+    }
+    return ERROR_AP_NONE;
+}
+
+static int repeats(int options, int target)
+{
+    return options >= target ? 1 : target / options;
+}
+
+static int run(int count, const char* names, char** args)
+{
+    measure_t m;
+    size_t written = 0;
+
+    measure_start(&m);
+    argsparse_create("bench");
+    argsparse_set_flags(ARGSPARSE_FLAG_QUIET);
+    argsparse_set_output(discard_output, &written, NULL, 0);
+    for (int i = 0; i < count; i++)
+    {
+        argsparse_add_int(names + (size_t)i * NAME_SIZE, "generated option", 0);
+    }
+    measure_report(&m, "add", count, 1, (unsigned long long)count);
+
+    int rounds = repeats(count, TARGET_OPS);
+    measure_start(&m);
+    for (int r = 0; r < rounds; r++)
+    {
+        if (argsparse_parse_args(args, count + 1) != count)
+        {
+            fprintf(stderr, "parse failed for %d options\n", count);
+            return 1;
+        }
+    }
+    measure_report(&m, "parse", count, 1, (unsigned long long)rounds * count);
+
+    // conversion left to lookups, none here
+    argsparse_set_flags(ARGSPARSE_FLAG_QUIET | ARGSPARSE_FLAG_LAZY);
+    measure_start(&m);
+    for (int r = 0; r < rounds; r++)
+    {
+        if (argsparse_parse_args(args, count + 1) != count)
+        {
+            fprintf(stderr, "lazy parse failed for %d options\n", count);
+            return 1;
+        }
+    }
+    measure_report(&m, "parse_lazy", count, 1, (unsigned long long)rounds * count);
+    argsparse_set_flags(ARGSPARSE_FLAG_QUIET);
+
+    // same options from an @file, written out once per schema
+    FILE* response = fopen(RESPONSE_FILE, "wb");
+    if (response == NULL)
+    {
+        fprintf(stderr, "cannot write %s\n", RESPONSE_FILE);
+        return 1;
+    }
+    for (int i = 0; i < count; i++)
+    {
+        fprintf(response, "%s\n", args[i + 1]);
+    }
+    fclose(response);
+
+    char response_arg[] = "@" RESPONSE_FILE;
+    char* response_args[] = { args[0], response_arg };
+    int response_rounds = repeats(count, TARGET_OPS / 10);
+    measure_start(&m);
+    for (int r = 0; r < response_rounds; r++)
+    {
+        if (argsparse_parse_args(response_args, 2) != count)
+        {
+            fprintf(stderr, "response file parse failed for %d options\n", count);
+            return 1;
+        }
+    }
+    measure_report(&m, "parse_response_file", count, 1, (unsigned long long)response_rounds * count);
+    remove(RESPONSE_FILE);
+
+    FILE* config = fopen(CONFIG_FILE, "wb");
+    if (config == NULL)
+    {
+        fprintf(stderr, "cannot write %s\n", CONFIG_FILE);
+        return 1;
+    }
+    for (int i = 0; i < count; i++)
+    {
+        fprintf(config, "%s = %d\n", names + (size_t)i * NAME_SIZE, i);
+    }
+    fclose(config);
+
+    // nothing set from the command line yet
+    argsparse_free();
+    argsparse_create("bench");
+    argsparse_set_flags(ARGSPARSE_FLAG_QUIET);
+    argsparse_set_output(discard_output, &written, NULL, 0);
+    for (int i = 0; i < count; i++)
+    {
+        argsparse_add_int(names + (size_t)i * NAME_SIZE, "generated option", 0);
+    }
+    measure_start(&m);
+    for (int r = 0; r < response_rounds; r++)
+    {
+        if (argsparse_load_config(CONFIG_FILE) != count)
+        {
+            fprintf(stderr, "config load failed for %d options\n", count);
+            return 1;
+        }
+    }
+    measure_report(&m, "load_config", count, 1, (unsigned long long)response_rounds * count);
+    remove(CONFIG_FILE);
+
+    int found = 0;
+    measure_start(&m);
+    for (int r = 0; r < rounds; r++)
+    {
+        for (int i = 0; i < count; i++)
+        {
+            found += argsparse_argument_by_name(names + (size_t)i * NAME_SIZE) != NULL;
+        }
+    }
+    measure_report(&m, "by_name", count, 1, (unsigned long long)rounds * count);
+
+    // ids are the insertion positions
+    long long sum = 0;
+    measure_start(&m);
+    for (int r = 0; r < rounds; r++)
+    {
+        for (int i = 0; i < count; i++)
+        {
+            sum += argsparse_get_int(i);
+        }
+    }
+    measure_report(&m, "get_int_by_id", count, 1, (unsigned long long)rounds * count);
+    found += sum > 0;
+
+    const char* shortopts = argsparse_get_shortopts();
+    size_t shortopts_length = strlen(shortopts);
+    measure_start(&m);
+    for (int r = 0; r < rounds; r++)
+    {
+        for (int i = 0; i < count; i++)
+        {
+            found += argsparse_argument_by_short_name(shortopts[(size_t)i % shortopts_length]) != NULL;
+        }
+    }
+    measure_report(&m, "by_short_name", count, 1, (unsigned long long)rounds * count);
+
+    int usages = repeats(count, TARGET_OPS / 100);
+    measure_start(&m);
+    for (int r = 0; r < usages; r++)
+    {
+        argsparse_show_usage(args[0]);
+    }
+    measure_report(&m, "show_usage", count, 1, (unsigned long long)usages);
+
+    // long options matched through the trie of the frozen schema
+    if (argsparse_freeze() != ERROR_AP_NONE)
+    {
+        fprintf(stderr, "freeze failed for %d options\n", count);
+        return 1;
+    }
+    measure_start(&m);
+    for (int r = 0; r < rounds; r++)
+    {
+        if (argsparse_parse_args(args, count + 1) != count)
+        {
+            fprintf(stderr, "frozen parse failed for %d options\n", count);
+            return 1;
+        }
+    }
+    measure_report(&m, "parse_frozen", count, 1, (unsigned long long)rounds * count);
+
+    measure_start(&m);
+    argsparse_free();
+    measure_report(&m, "free", count, 1, 1);
+
+    // registration replaced by the schema cache, the first create writes it
+    schema_t schema = { names, count };
+    remove(CACHE_FILE);
+    measure_start(&m);
+    ARG_DATA_HANDLE cached = argsparse_ctx_create_cached("bench", CACHE_FILE, count, build_schema, &schema);
+    measure_report(&m, "create_cached_miss", count, 1, (unsigned long long)count);
+    argsparse_ctx_free(cached);
+
+    int cache_rounds = repeats(count, TARGET_OPS / 10);
+    measure_start(&m);
+    for (int r = 0; r < cache_rounds; r++)
+    {
+        cached = argsparse_ctx_create_cached("bench", CACHE_FILE, count, build_schema, &schema);
+        found += cached && argsparse_ctx_argument_count(cached) == count;
+        argsparse_ctx_free(cached);
+    }
+    measure_report(&m, "create_cached", count, 1, (unsigned long long)cache_rounds * count);
+    remove(CACHE_FILE);
+
+    if (found == 0 || written == 0)
+    {
+        fprintf(stderr, "nothing found or written for %d options\n", count);
+        return 1;
+    }
+    return 0;
+}
+
+/// @brief BATCH_SIZE argv vectors of BATCH_OPTIONS options through
+/// argsparse_parse_batch with doubling thread counts
+static int run_batch(const char* names, char** args)
+{
+    char** argv = malloc((BATCH_OPTIONS + 2) * sizeof(char*));
+    char*** argv_list = malloc(BATCH_SIZE * sizeof(char**));
+    ARG_RESULT_HANDLE* results = malloc(BATCH_SIZE * sizeof(ARG_RESULT_HANDLE));
+    if (!argv || !argv_list || !results)
+        return 1;
+
+    memcpy(argv, args, (BATCH_OPTIONS + 1) * sizeof(char*));
+    argv[BATCH_OPTIONS + 1] = NULL;
+    for (int i = 0; i < BATCH_SIZE; i++)
+    {
+        argv_list[i] = argv;
+    }
+
+    argsparse_create("bench");
+    for (int i = 0; i < BATCH_OPTIONS; i++)
+    {
+        argsparse_add_int(names + (size_t)i * NAME_SIZE, "generated option", 0);
+    }
+
+    int ret = 0;
+    for (int threads = 1; ret == 0 && threads <= BATCH_MAX_THREADS; threads *= 2)
+    {
+        measure_t m;
+        measure_start(&m);
+        if (argsparse_parse_batch((char* const* const*)argv_list, BATCH_SIZE, results, threads) != BATCH_SIZE)
+        {
+            fprintf(stderr, "batch parse failed on %d threads\n", threads);
+            ret = 1;
+        }
+        measure_report(&m, "parse_batch", BATCH_OPTIONS, threads, BATCH_SIZE);
+        for (int i = 0; i < BATCH_SIZE; i++)
+        {
+            argsparse_result_free(results[i]);
+        }
+    }
+    argsparse_free();
+
+    free(results);
+    free(argv_list);
+    free(argv);
+    return ret;
+}
+
+/// @brief Tokenizing and parsing SCAN_ENTRIES argv entries, file operands
+/// and long options with path values in turns, at every scan level the
+/// processor supports
+static int run_scan(const char* names)
+{
+    static const char* const level_names[] = { "scalar", "sse2", "avx2" };
+    size_t capacity = (size_t)SCAN_ENTRIES * (NAME_SIZE + 32);
+    char* line = malloc(capacity);
+    char* work = malloc(capacity);
+    char** argv = malloc((SCAN_ENTRIES + 2) * sizeof(char*));
+    if (!line || !work || !argv)
+        return 1;
+
+    size_t length = (size_t)sprintf(line, "bench");
+    for (int i = 0; i < SCAN_ENTRIES; i++)
+    {
+        if (i % 2)
+            length += (size_t)sprintf(line + length, " --%s=/srv/data/input/file-%06d.bin", names + (size_t)(i % BATCH_OPTIONS) * NAME_SIZE, i);
+        else
+            length += (size_t)sprintf(line + length, " /srv/data/input/file-%06d.bin", i);
+    }
+
+    argsparse_create("bench");
+    argsparse_set_flags(ARGSPARSE_FLAG_QUIET);
+    for (int i = 0; i < BATCH_OPTIONS; i++)
+    {
+        argsparse_add_cstr(names + (size_t)i * NAME_SIZE, "generated option", "none");
+    }
+
+    int ret = 0;
+    for (int level = SCAN_SCALAR; ret == 0 && level <= SCAN_AVX2; level++)
+    {
+        if ((int)scan_set_level((scan_level_e)level) != level)
+            continue;
+
+        // the line is copied back every round, tokenizing works in place
+        char op[32];
+        int count = 0;
+        measure_t m;
+        measure_start(&m);
+        for (int r = 0; r < SCAN_ROUNDS; r++)
+        {
+            memcpy(work, line, length + 1);
+            count = argsparse_tokenize(work, argv, SCAN_ENTRIES + 2);
+        }
+        snprintf(op, sizeof(op), "tokenize_%s", level_names[level]);
+        measure_report(&m, op, BATCH_OPTIONS, 1, (unsigned long long)SCAN_ROUNDS * SCAN_ENTRIES);
+
+        measure_start(&m);
+        for (int r = 0; ret == 0 && r < SCAN_ROUNDS; r++)
+        {
+            if (count != SCAN_ENTRIES + 1 || argsparse_parse_args(argv, count) != SCAN_ENTRIES / 2)
+            {
+                fprintf(stderr, "scan parse failed at level %s\n", level_names[level]);
+                ret = 1;
+            }
+        }
+        snprintf(op, sizeof(op), "parse_operands_%s", level_names[level]);
+        measure_report(&m, op, BATCH_OPTIONS, 1, (unsigned long long)SCAN_ROUNDS * SCAN_ENTRIES);
+    }
+    scan_set_level(SCAN_AVX2);
+    argsparse_free();
+
+    free(argv);
+    free(work);
+    free(line);
+    return ret;
+}
+
+int main(int argc, char** argv)
+{
+    const int counts[] = { 10, 100, 1000, 10000, 100000 };
+    int max_count = argc > 1 ? atoi(argv[1]) : counts[sizeof(counts) / sizeof(counts[0]) - 1];
+    if (max_count < counts[0])
+    {
+        fprintf(stderr, "usage: %s [max options >= %d]\n", argv[0], counts[0]);
+        return 1;
+    }
+
+    char* names = malloc((size_t)max_count * NAME_SIZE);
+    char* tokens = malloc((size_t)max_count * NAME_SIZE);
+    char** args = malloc(((size_t)max_count + 1) * sizeof(char*));
+    if (!names || !tokens || !args)
+        return 1;
+
+    for (int i = 0; i < max_count; i++)
+    {
+        snprintf(names + (size_t)i * NAME_SIZE, NAME_SIZE, "option%d", i);
+        snprintf(tokens + (size_t)i * NAME_SIZE, NAME_SIZE, "--option%d=%d", i, i);
+        args[i + 1] = tokens + (size_t)i * NAME_SIZE;
+    }
+    args[0] = argv[0];
+
+    int ret = 0;
+    for (size_t c = 0; ret == 0 && c < sizeof(counts) / sizeof(counts[0]) && counts[c] <= max_count; c++)
+    {
+        ret = run(counts[c], names, args);
+    }
+    if (ret == 0)
+    {
+        ret = run_batch(names, args);
+    }
+    if (ret == 0)
+    {
+        ret = run_scan(names);
+    }
+
+    free(args);
+    free(tokens);
+    free(names);
+    return ret;
+}
@@ -1,5 +1,7 @@
 
-include(${CMAKE_CURRENT_LIST_DIR}/../cmake/getopt.cmake)
+if(MSVC)
+  add_definitions(-D_CRT_SECURE_NO_WARNINGS)
+endif()
 
 # Main source directory
 include_directories(
@@ -8,10 +10,26 @@ include_directories(
     $ENV{EXTRA_INCLUDES})
 
 list(APPEND SourceFiles
+    ${CMAKE_CURRENT_LIST_DIR}/../lib/src/arena.c
     ${CMAKE_CURRENT_LIST_DIR}/../lib/src/argsparse.c
+    ${CMAKE_CURRENT_LIST_DIR}/../lib/src/config.c
+    ${CMAKE_CURRENT_LIST_DIR}/../lib/src/file_map.c
+    ${CMAKE_CURRENT_LIST_DIR}/../lib/src/freeze.c
     ${CMAKE_CURRENT_LIST_DIR}/../lib/src/internal_funcs.c
+    ${CMAKE_CURRENT_LIST_DIR}/../lib/src/name_index.c
+    ${CMAKE_CURRENT_LIST_DIR}/../lib/src/output.c
+    ${CMAKE_CURRENT_LIST_DIR}/../lib/src/parser.c
+    ${CMAKE_CURRENT_LIST_DIR}/../lib/src/result.c
+    ${CMAKE_CURRENT_LIST_DIR}/../lib/src/scan.c
+    ${CMAKE_CURRENT_LIST_DIR}/../lib/src/serialize.c
+    ${CMAKE_CURRENT_LIST_DIR}/../lib/src/string_pool.c
+    ${CMAKE_CURRENT_LIST_DIR}/../lib/src/thread_pool.c
+    ${CMAKE_CURRENT_LIST_DIR}/../lib/src/tokenizer.c
 )
 
 add_library(${PROJECT_NAME}-lib ${SourceFiles})
 
+find_package(Threads REQUIRED)
+target_link_libraries(${PROJECT_NAME}-lib Threads::Threads)
+
 target_include_directories(${PROJECT_NAME}-lib PUBLIC ${CMAKE_CURRENT_LIST_DIR}/../include)
\ No newline at end of file
@@ -3,6 +3,8 @@
 #include <stdio.h>
 
 int gFlag = 0;
+int gIntegerId = -1;
+int gDoubleId = -1;
 
 int err_print(int err, const char *message);
 
@@ -19,6 +21,7 @@ int main(int argc, char **argv)
         int parsed = argsparse_parse_args(argv, argc);
         printf("shortopts %s - %d arguments parsed\n", argsparse_get_shortopts(), parsed);
         argsparse_show_arguments();
+        printf("integer %d double %f\n", argsparse_get_int(gIntegerId), argsparse_get_double(gDoubleId));
     }
     catch (...)
     {
@@ -32,11 +35,11 @@ void initialize_arguments()
     ARG_ERROR err = ERROR_AP_NONE;
     err = argsparse_add_help();
     err_print(err, "help not added");
-    err = argsparse_add_int("integer", "This is an integer value", 0);
-    err_print(err, "integer not added");
+    gIntegerId = argsparse_add_int_id("integer", "This is an integer value", 0);
+    err_print(gIntegerId < 0 ? gIntegerId : ERROR_AP_NONE, "integer not added");
 
-    err = argsparse_add_double("double", "This is a double value", 0.0);
-    err_print(err, "double not added");
+    gDoubleId = argsparse_add_double_id("double", "This is a double value", 0.0);
+    err_print(gDoubleId < 0 ? gDoubleId : ERROR_AP_NONE, "double not added");
 
     err = argsparse_add_cstr("string", "This is a string value", "");
     err_print(err, "string not added");
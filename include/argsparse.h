@@ -14,21 +14,28 @@ extern "C"
 {
 #endif
 
+#include <stddef.h>
+#include <stdint.h>
+
 #ifndef ARGSPARSE_MAX_STRING_SIZE
 #   define ARGSPARSE_MAX_STRING_SIZE 80
 #endif
 
-#ifndef ARGSPARSE_MAX_ARGS
-#   define ARGSPARSE_MAX_ARGS 40
-#endif
-
 typedef enum _argsparse_errors {
     ERROR_AP_NONE = 0,
     ERROR_AP_UNKNOWN = -1,
+    /// @brief reserved, the argument count is no longer limited
     ERROR_AP_MAX_ARGS = -2,
     ERROR_AP_EXISTS = -3,
     ERROR_AP_MEMORY = -4,
     ERROR_AP_HANDLE = -5,
+    ERROR_AP_FROZEN = -6,
+    /// @brief value is not valid for the argument type
+    ERROR_AP_FORMAT = -7,
+    /// @brief value does not fit the argument type
+    ERROR_AP_RANGE = -8,
+    /// @brief file cannot be opened or read
+    ERROR_AP_FILE = -9,
 } e_argsparse_errors;
 
 typedef enum _argsparse_type {
@@ -42,9 +49,52 @@ typedef enum _argsparse_type {
     ARGSPARSE_TYPE_CNT
 } argsparse_type_e;
 
+typedef enum _argsparse_flags {
+    ARGSPARSE_FLAG_NONE = 0,
+    /// @brief copy parsed string values into the arguments structure,
+    /// by default they point into the parsed argv. Each argument keeps one
+    /// copy, a value stays valid until the argument is set again.
+    ARGSPARSE_FLAG_COPY_STRINGS = 1 << 0,
+    /// @brief parsing writes no diagnostics, errors are only returned
+    /// or reported through the exit code
+    ARGSPARSE_FLAG_QUIET = 1 << 1,
+    /// @brief parsing records the option text only and converts it on the
+    /// first lookup of the argument, which keeps the converted value. A
+    /// value that does not convert is reported then and leaves the
+    /// previous value and source in place, the parse has counted it.
+    /// The text points into argv, which has to outlive the lookups,
+    /// unless ARGSPARSE_FLAG_COPY_STRINGS is set.
+    /// Look arguments up after parsing, lookups are not thread-safe.
+    ARGSPARSE_FLAG_LAZY = 1 << 2,
+} argsparse_flags_e;
+
+/// @brief Where the value of an argument came from, stored in parsed.
+/// Command line values take precedence over environment variables and
+/// those over configuration files.
+typedef enum _argsparse_source {
+    ARGSPARSE_SOURCE_DEFAULT = 0,
+    ARGSPARSE_SOURCE_CMDLINE = 1,
+    ARGSPARSE_SOURCE_CONFIG = 2,
+    ARGSPARSE_SOURCE_ENV = 3,
+} argsparse_source_e;
+
+typedef enum _argsparse_stream {
+    ARGSPARSE_STREAM_OUT = 1,
+    ARGSPARSE_STREAM_ERR = 2,
+} argsparse_stream_e;
+
+/// @brief Output callback
+/// @param context as given to argsparse_set_output
+/// @param stream ARGSPARSE_STREAM_OUT or ARGSPARSE_STREAM_ERR
+/// @param text not NUL-terminated
+/// @param length bytes of text
+typedef void (*argsparse_write_fn)(void* context, int stream, const char* text, size_t length);
+
 typedef union _argparse_value
 {
-    char stringvalue[ARGSPARSE_MAX_STRING_SIZE];
+    /// @brief NUL-terminated, defaults are owned by the arguments structure,
+    /// parsed values point into argv unless ARGSPARSE_FLAG_COPY_STRINGS is set
+    const char* stringvalue;
     int* flagptr;
     int intvalue;
     double doublevalue;
@@ -55,19 +105,38 @@ typedef union _argparse_value ARG_VALUE;
 typedef struct _argparse_argument
 {
     argsparse_type_e type;
+    /// @brief ARGSPARSE_SOURCE_* of value, nonzero once set
     int parsed;
+    /// @brief position in insertion order
+    int index;
     int name_short;
-    char name[ARGSPARSE_MAX_STRING_SIZE];
-    char description[ARGSPARSE_MAX_STRING_SIZE];
+    /// @brief interned in the arguments structure string pool
+    const char* name;
+    /// @brief interned in the arguments structure string pool
+    const char* description;
     union {
         int flagvalue;
         ARG_VALUE initvalue;
     } flag_init;
     ARG_VALUE value;
+    /// @brief flag target when no pointer was given
+    int flagstorage;
+    /// @brief pooled environment variable given to argsparse_bind_env,
+    /// NULL derives one from the prefix
+    const char* env;
+    /// @brief option text of a lazy parse until converted, otherwise NULL
+    const char* raw;
+    /// @brief parsed before the lazy option, restored when raw does not convert
+    int raw_parsed;
+    /// @brief copy of the last value set with ARGSPARSE_FLAG_COPY_STRINGS,
+    /// reused by the next one and freed with the arguments structure
+    char* copy;
+    size_t copy_size;
 } argsparse_argument_t;
 
 typedef struct _argparse_argument* ARG_ARGUMENT_HANDLE;
 typedef struct _argparse_data* ARG_DATA_HANDLE;
+typedef struct _argparse_result* ARG_RESULT_HANDLE;
 typedef enum _argsparse_type ARG_TYPE;
 typedef enum _argsparse_errors ARG_ERROR;
 
@@ -79,6 +148,23 @@ ARG_ERROR argsparse_create(const char* title);
 /// @brief Free arguments structure
 void argsparse_free();
 
+/// @brief Set behaviour flags
+/// @param flags ARGSPARSE_FLAG_* bits
+void argsparse_set_flags(int flags);
+
+/// @brief Get behaviour flags
+/// @return ARGSPARSE_FLAG_* bits
+int argsparse_get_flags();
+
+/// @brief Set the output sink. Usage, argument values and diagnostics
+/// are assembled into buffer and written with one call when complete or
+/// when the buffer fills up.
+/// @param write callback or NULL for stdout and stderr
+/// @param context passed to write
+/// @param buffer caller owned, NULL for an internal one
+/// @param size of buffer
+void argsparse_set_output(argsparse_write_fn write, void* context, char* buffer, size_t size);
+
 /// @brief Adds argument using the structured format
 /// @param handle
 /// @param name
@@ -90,7 +176,9 @@ void argsparse_free();
 ///
 /// ERROR_AP_EXISTS - argument with same name already exists
 ///
-/// ERROR_AP_MAX_ARGS(1) - ARGSPARSE_MAX_ARGS reached, not added
+/// ERROR_AP_MEMORY - out of memory, not added
+///
+/// ERROR_AP_FROZEN - argsparse_freeze already called, not added
 /// @note Smells like internal, but having invested
 /// a quite a lot to testing it decided to drag it along.
 ARG_ERROR argsparse_add(const char* name, const char* description, ARG_TYPE type, const ARG_VALUE* value);
@@ -102,7 +190,9 @@ ARG_ERROR argsparse_add(const char* name, const char* description, ARG_TYPE type
 ///
 /// ERROR_AP_EXISTS - argument with same name already exists
 ///
-/// ERROR_AP_MAX_ARGS(1) - ARGSPARSE_MAX_ARGS reached, not added
+/// ERROR_AP_MEMORY - out of memory, not added
+///
+/// ERROR_AP_FROZEN - argsparse_freeze already called, not added
 ARG_ERROR argsparse_add_help();
 
 /// @brief Add int argument
@@ -115,7 +205,9 @@ ARG_ERROR argsparse_add_help();
 ///
 /// ERROR_AP_EXISTS - argument with same name already exists
 ///
-/// ERROR_AP_MAX_ARGS(1) - ARGSPARSE_MAX_ARGS reached, not added
+/// ERROR_AP_MEMORY - out of memory, not added
+///
+/// ERROR_AP_FROZEN - argsparse_freeze already called, not added
 ARG_ERROR argsparse_add_int(const char* name, const char* desc, int value);
 
 /// @brief Add DOUBLE argument
@@ -128,7 +220,9 @@ ARG_ERROR argsparse_add_int(const char* name, const char* desc, int value);
 ///
 /// ERROR_AP_EXISTS - argument with same name already exists
 ///
-/// ERROR_AP_MAX_ARGS(1) - ARGSPARSE_MAX_ARGS reached, not added
+/// ERROR_AP_MEMORY - out of memory, not added
+///
+/// ERROR_AP_FROZEN - argsparse_freeze already called, not added
 ARG_ERROR argsparse_add_double(const char* name, const char* description, double value);
 
 /// @brief Add string argument
@@ -141,7 +235,9 @@ ARG_ERROR argsparse_add_double(const char* name, const char* description, double
 ///
 /// ERROR_AP_EXISTS - argument with same name already exists
 ///
-/// ERROR_AP_MAX_ARGS(1) - ARGSPARSE_MAX_ARGS reached, not added
+/// ERROR_AP_MEMORY - out of memory, not added
+///
+/// ERROR_AP_FROZEN - argsparse_freeze already called, not added
 ARG_ERROR argsparse_add_cstr(const char* name, const char* description, const char* value);
 
 /// @brief Add argument flag only
@@ -155,20 +251,113 @@ ARG_ERROR argsparse_add_cstr(const char* name, const char* description, const ch
 ///
 /// ERROR_AP_EXISTS - argument with same name already exists
 ///
-/// ERROR_AP_MAX_ARGS(1) - ARGSPARSE_MAX_ARGS reached, not added
+/// ERROR_AP_MEMORY - out of memory, not added
+///
+/// ERROR_AP_FROZEN - argsparse_freeze already called, not added
 ARG_ERROR argsparse_add_flag(const char* name, const char* description, int value, int* ptr_to_value);
 
 /// @brief Parse cmdline argument against added arguments 
 /// @param handle Handle to allocated arguments structure
 /// @param argsv
 /// @param argc
+/// @return parsed argument count or
+///
+/// ERROR_AP_FORMAT - option value is not valid for its type, parsing stopped
+///
+/// ERROR_AP_RANGE - option value does not fit its type, parsing stopped
+/// @note An "@path" element is replaced by the whitespace separated, shell
+/// quoted contents of the file, nested up to 8 levels. Elements naming
+/// files that cannot be read are kept as they are. The files stay mapped
+/// until the next parse or argsparse_reset, string values still read from
+/// them are copied to their arguments then.
 int argsparse_parse_args(char* const* argv, int argc);
 
-/// @brief Prints usage message
+/// @brief Load values from a configuration file of "name = value" lines.
+/// Empty lines, '#' and ';' comments and [section] headers are skipped, a
+/// value may be quoted. A flag given without value or as 1, true, yes or
+/// on is set, 0, false, no or off leave it unset. Arguments already set
+/// from the command line or the environment keep their value, the file
+/// may be loaded before or after them.
+/// @param path
+/// @return count of values set or
+///
+/// ERROR_AP_FILE - file cannot be read
+///
+/// ERROR_AP_UNKNOWN - name is not an argument, loading stopped
+///
+/// ERROR_AP_FORMAT - value is not valid for the argument type, loading stopped
+///
+/// ERROR_AP_RANGE - value does not fit the argument type, loading stopped
+/// @note Loading stops at the first bad line, the values of the lines
+/// before it stay set. String values point into the file, which stays
+/// mapped until the next load, string values still read from it are
+/// copied to their arguments then.
+int argsparse_load_config(const char* path);
+
+/// @brief Derive environment variables of arguments not bound with
+/// argsparse_bind_env from prefix and the name in upper case, characters
+/// other than letters and digits replaced with '_': "APP_" and "cache-mb"
+/// give APP_CACHE_MB
+/// @param prefix copied, NULL for only the bound variables
+void argsparse_set_env_prefix(const char* prefix);
+
+/// @brief Bind argument to an environment variable
+/// @param name argument name
+/// @param variable copied, NULL to derive one from the prefix again
+/// @return
+/// ERROR_AP_NONE(0) - success
+///
+/// ERROR_AP_UNKNOWN - no argument by name
+ARG_ERROR argsparse_bind_env(const char* name, const char* variable);
+
+/// @brief Load values of the bound and derived environment variables with one
+/// pass over the environment. Values are converted like in configuration
+/// files and set unless the command line did, the environment may be loaded
+/// before or after parsing.
+/// @param envp NULL terminated "NAME=value" array, NULL for the process environment
+/// @return count of values set or
+///
+/// ERROR_AP_FORMAT - value is not valid for the argument type, loading stopped
+///
+/// ERROR_AP_RANGE - value does not fit the argument type, loading stopped
+///
+/// ERROR_AP_MEMORY - out of memory
+/// @note string values point into envp
+int argsparse_load_env(char* const* envp);
+
+/// @brief Parse many argv vectors against the arguments concurrently, each
+/// into its own result. The arguments are frozen first and not modified,
+/// nothing is printed and nothing exits, errors go to the result status.
+/// @param argv_list count NULL terminated argv vectors
+/// @param count
+/// @param results count slots receiving results to free with
+/// argsparse_result_free, NULL when out of memory
+/// @param nthreads 0 or less for one per processor
+/// @return count of results parsed without error or
+///
+/// ERROR_AP_MEMORY - freezing failed, no results
+/// @note string values point into argv and response files are owned by
+/// the result
+int argsparse_parse_batch(char* const* const* argv_list, int count, ARG_RESULT_HANDLE* results, int nthreads);
+
+/// @brief Compile the added arguments into a read-only parse image
+/// reused by every following parse and lookup
+/// @return
+/// ERROR_AP_NONE(0) - success, also when already frozen
+///
+/// ERROR_AP_MEMORY - image allocation failed
+/// @note Adding arguments afterwards fails with ERROR_AP_FROZEN
+ARG_ERROR argsparse_freeze();
+
+/// @brief Restore the values captured by argsparse_freeze and clear parsed,
+/// does nothing when not frozen
+void argsparse_reset();
+
+/// @brief Writes usage message to the output sink
 /// @param handle
 void argsparse_show_usage(const char* const executable);
 
-/// @brief Prints argument values
+/// @brief Writes argument values to the output sink
 /// @param handle
 void argsparse_show_arguments();
 
@@ -199,6 +388,383 @@ ARG_ARGUMENT_HANDLE argsparse_argument_by_short_name(int shortname);
 /// @return count
 int argsparse_argument_count();
 
+////////////////////////
+// Context handle API //
+////////////////////////
+
+// Same operations on explicitly created handles. Each handle is
+// independent of the others and of the global one used above.
+
+/// @brief Create arguments structure
+/// @param title
+/// @return handle or NULL when out of memory
+ARG_DATA_HANDLE argsparse_ctx_create(const char* title);
+
+/// @brief Free arguments structure
+/// @param handle null-safe
+void argsparse_ctx_free(ARG_DATA_HANDLE handle);
+
+/// @brief Set behaviour flags
+/// @see argsparse_set_flags
+/// @return ERROR_AP_HANDLE when handle is NULL
+ARG_ERROR argsparse_ctx_set_flags(ARG_DATA_HANDLE handle, int flags);
+
+/// @brief Get behaviour flags
+/// @return ARGSPARSE_FLAG_* bits, 0 when handle is NULL
+int argsparse_ctx_get_flags(ARG_DATA_HANDLE handle);
+
+/// @brief Set the output sink
+/// @see argsparse_set_output
+/// @return ERROR_AP_HANDLE when handle is NULL
+ARG_ERROR argsparse_ctx_set_output(ARG_DATA_HANDLE handle, argsparse_write_fn write, void* context, char* buffer, size_t size);
+
+/// @brief Adds argument using the structured format
+/// @see argsparse_add
+/// @return ERROR_AP_HANDLE when handle is NULL
+ARG_ERROR argsparse_ctx_add(ARG_DATA_HANDLE handle, const char* name, const char* description, ARG_TYPE type, const ARG_VALUE* value);
+
+/// @brief Add help option showing usage with exit
+/// @see argsparse_add_help
+/// @return ERROR_AP_HANDLE when handle is NULL
+ARG_ERROR argsparse_ctx_add_help(ARG_DATA_HANDLE handle);
+
+/// @brief Add int argument
+/// @see argsparse_add_int
+/// @return ERROR_AP_HANDLE when handle is NULL
+ARG_ERROR argsparse_ctx_add_int(ARG_DATA_HANDLE handle, const char* name, const char* description, int value);
+
+/// @brief Add DOUBLE argument
+/// @see argsparse_add_double
+/// @return ERROR_AP_HANDLE when handle is NULL
+ARG_ERROR argsparse_ctx_add_double(ARG_DATA_HANDLE handle, const char* name, const char* description, double value);
+
+/// @brief Add string argument
+/// @see argsparse_add_cstr
+/// @return ERROR_AP_HANDLE when handle is NULL
+ARG_ERROR argsparse_ctx_add_cstr(ARG_DATA_HANDLE handle, const char* name, const char* description, const char* value);
+
+/// @brief Add argument flag only
+/// @see argsparse_add_flag
+/// @return ERROR_AP_HANDLE when handle is NULL
+ARG_ERROR argsparse_ctx_add_flag(ARG_DATA_HANDLE handle, const char* name, const char* description, int value, int* ptr_to_value);
+
+/// @brief Parse cmdline argument against added arguments
+/// @see argsparse_parse_args
+/// @return parsed count or ERROR_AP_HANDLE when handle is NULL
+int argsparse_ctx_parse_args(ARG_DATA_HANDLE handle, char* const* argv, int argc);
+
+/// @brief Load values from a configuration file
+/// @see argsparse_load_config
+/// @return count of values set or error, ERROR_AP_HANDLE when handle is NULL
+int argsparse_ctx_load_config(ARG_DATA_HANDLE handle, const char* path);
+
+/// @brief Set the environment variable prefix
+/// @see argsparse_set_env_prefix
+/// @return ERROR_AP_HANDLE when handle is NULL
+ARG_ERROR argsparse_ctx_set_env_prefix(ARG_DATA_HANDLE handle, const char* prefix);
+
+/// @brief Bind argument to an environment variable
+/// @see argsparse_bind_env
+/// @return ERROR_AP_HANDLE when handle is NULL
+ARG_ERROR argsparse_ctx_bind_env(ARG_DATA_HANDLE handle, const char* name, const char* variable);
+
+/// @brief Load values from the environment
+/// @see argsparse_load_env
+/// @return count of values set or error, ERROR_AP_HANDLE when handle is NULL
+int argsparse_ctx_load_env(ARG_DATA_HANDLE handle, char* const* envp);
+
+/// @brief Parse many argv vectors concurrently
+/// @see argsparse_parse_batch
+/// @return count of results parsed without error or error, ERROR_AP_HANDLE when handle is NULL
+int argsparse_ctx_parse_batch(ARG_DATA_HANDLE handle, char* const* const* argv_list, int count, ARG_RESULT_HANDLE* results, int nthreads);
+
+/// @brief Compile the added arguments into a read-only parse image
+/// @see argsparse_freeze
+/// @return ERROR_AP_HANDLE when handle is NULL
+ARG_ERROR argsparse_ctx_freeze(ARG_DATA_HANDLE handle);
+
+/// @brief Restore the values captured by freeze
+/// @see argsparse_reset
+void argsparse_ctx_reset(ARG_DATA_HANDLE handle);
+
+/// @brief Writes usage message, does nothing when handle is NULL
+void argsparse_ctx_show_usage(ARG_DATA_HANDLE handle, const char* const executable);
+
+/// @brief Writes argument values, does nothing when handle is NULL
+void argsparse_ctx_show_arguments(ARG_DATA_HANDLE handle);
+
+/// @brief Get title
+/// @return string or NULL when handle is NULL
+const char* argsparse_ctx_get_title(ARG_DATA_HANDLE handle);
+
+/// @brief Get short options
+/// @return string or NULL when handle is NULL
+char* argsparse_ctx_get_shortopts(ARG_DATA_HANDLE handle);
+
+/// @brief Get argument by name
+/// @return handle to argument or NULL
+ARG_ARGUMENT_HANDLE argsparse_ctx_argument_by_name(ARG_DATA_HANDLE handle, const char* name);
+
+/// @brief Get argument by short name
+/// @return handle to argument or NULL
+ARG_ARGUMENT_HANDLE argsparse_ctx_argument_by_short_name(ARG_DATA_HANDLE handle, int shortname);
+
+/// @brief Get argument count
+/// @return count, 0 when handle is NULL
+int argsparse_ctx_argument_count(ARG_DATA_HANDLE handle);
+
+/////////////
+// Results //
+/////////////
+
+// Values of one parse kept apart from the arguments, which stay as the
+// frozen schema. Any number of results can be parsed against one handle,
+// concurrently too, at 8 bytes and a bit per argument. A result is valid
+// as long as its handle.
+
+/// @brief Create result for the global handle
+/// @see argsparse_ctx_result_create
+ARG_RESULT_HANDLE argsparse_result_create();
+
+/// @brief Create result holding the argument defaults, freezes the handle
+/// @return result or NULL when handle is NULL or out of memory
+ARG_RESULT_HANDLE argsparse_ctx_result_create(ARG_DATA_HANDLE handle);
+
+/// @brief Free result, null-safe
+void argsparse_result_free(ARG_RESULT_HANDLE result);
+
+/// @brief Parse argv into result, starting over from the defaults. Neither
+/// the handle nor the other results are modified, nothing is printed and
+/// nothing exits.
+/// @return parsed count or
+///
+/// ERROR_AP_UNKNOWN - unknown or ambiguous option, missing or unexpected value
+///
+/// ERROR_AP_FORMAT - option value is not valid for its type
+///
+/// ERROR_AP_RANGE - option value does not fit its type
+///
+/// ERROR_AP_HANDLE - result is NULL
+/// @note string values point into argv
+int argsparse_result_parse(ARG_RESULT_HANDLE result, char* const* argv, int argc);
+
+/// @brief Outcome of the parse
+/// @return parsed count or error as returned by argsparse_parse_args,
+/// ERROR_AP_UNKNOWN for option errors, ERROR_AP_HANDLE when result is NULL
+int argsparse_result_status(ARG_RESULT_HANDLE result);
+
+/// @brief Get value by argument name, the default when not parsed.
+/// Flags hold the int value in intvalue.
+/// @return value or NULL when no argument by name
+const ARG_VALUE* argsparse_result_value(ARG_RESULT_HANDLE result, const char* name);
+
+/// @brief Get parse state by argument name
+/// @return 1 when parsed, 0 when not or no argument by name
+int argsparse_result_parsed(ARG_RESULT_HANDLE result, const char* name);
+
+/// @brief Get argument count of the result
+/// @return count, 0 when result is NULL
+int argsparse_result_count(ARG_RESULT_HANDLE result);
+
+/// @brief Get value by argument position
+/// @param index ARG_ARGUMENT_HANDLE index, insertion order
+/// @return value or NULL when out of range
+const ARG_VALUE* argsparse_result_value_at(ARG_RESULT_HANDLE result, int index);
+
+/// @brief Get parse state by argument position
+/// @return 1 when parsed, 0 when not or out of range
+int argsparse_result_parsed_at(ARG_RESULT_HANDLE result, int index);
+
+/////////
+// Ids //
+/////////
+
+// An id is the position of an argument in insertion order, stable for
+// the life of its handle, also when restored from an image or a cache.
+// The typed accessors reduce to an array index and a type check, for
+// values read in loops.
+
+/// @brief argsparse_add_int returning the id
+/// @see argsparse_ctx_add_int_id
+int argsparse_add_int_id(const char* name, const char* description, int value);
+
+/// @brief argsparse_add_double returning the id
+/// @see argsparse_ctx_add_int_id
+int argsparse_add_double_id(const char* name, const char* description, double value);
+
+/// @brief argsparse_add_cstr returning the id
+/// @see argsparse_ctx_add_int_id
+int argsparse_add_cstr_id(const char* name, const char* description, const char* value);
+
+/// @brief argsparse_add_flag returning the id
+/// @see argsparse_ctx_add_int_id
+int argsparse_add_flag_id(const char* name, const char* description, int value, int* ptr_to_value);
+
+/// @brief Id of argument by name, for arguments added without one
+/// @return id or ERROR_AP_UNKNOWN
+int argsparse_argument_id(const char* name);
+
+/// @brief Value of int argument id, 0 when id is not an int argument
+int argsparse_get_int(int id);
+
+/// @brief Value of double argument id, 0.0 when id is not a double argument
+double argsparse_get_double(int id);
+
+/// @brief Value of string argument id, NULL when id is not a string argument
+const char* argsparse_get_cstr(int id);
+
+/// @brief Value of flag argument id, 0 when id is not a flag argument
+int argsparse_get_flag(int id);
+
+/// @brief Source of the value of argument id
+/// @return ARGSPARSE_SOURCE_*, nonzero once set, 0 when id is out of range
+int argsparse_is_parsed(int id);
+
+/// @brief Add int argument and return its id
+/// @return id (>= 0) or the ARG_ERROR of argsparse_ctx_add_int
+int argsparse_ctx_add_int_id(ARG_DATA_HANDLE handle, const char* name, const char* description, int value);
+
+/// @see argsparse_ctx_add_int_id
+int argsparse_ctx_add_double_id(ARG_DATA_HANDLE handle, const char* name, const char* description, double value);
+
+/// @see argsparse_ctx_add_int_id
+int argsparse_ctx_add_cstr_id(ARG_DATA_HANDLE handle, const char* name, const char* description, const char* value);
+
+/// @see argsparse_ctx_add_int_id
+int argsparse_ctx_add_flag_id(ARG_DATA_HANDLE handle, const char* name, const char* description, int value, int* ptr_to_value);
+
+/// @see argsparse_argument_id
+int argsparse_ctx_argument_id(ARG_DATA_HANDLE handle, const char* name);
+
+/// @see argsparse_get_int
+int argsparse_ctx_get_int(ARG_DATA_HANDLE handle, int id);
+
+/// @see argsparse_get_double
+double argsparse_ctx_get_double(ARG_DATA_HANDLE handle, int id);
+
+/// @see argsparse_get_cstr
+const char* argsparse_ctx_get_cstr(ARG_DATA_HANDLE handle, int id);
+
+/// @see argsparse_get_flag
+int argsparse_ctx_get_flag(ARG_DATA_HANDLE handle, int id);
+
+/// @see argsparse_is_parsed
+int argsparse_ctx_is_parsed(ARG_DATA_HANDLE handle, int id);
+
+///////////////
+// Tokenizer //
+///////////////
+
+/// @brief Split a command line into argv in place, reentrant and without
+/// allocation. Tokens are separated by whitespace, 'single quotes' are
+/// literal, inside "double quotes" a backslash escapes '"', '\\', '$' and
+/// '`', elsewhere it escapes any character. Quotes and escapes are removed
+/// in buffer and the tokens point into it.
+/// @param buffer NUL-terminated, modified
+/// @param argv receives the tokens and a NULL after them
+/// @param argv_size capacity of argv including the NULL
+/// @return token count, the argc for argsparse_parse_args when the first
+/// token is the program name. A count of argv_size or more means argv
+/// holds the first argv_size - 1 tokens only.
+///
+/// ERROR_AP_FORMAT - a quote is not closed
+///
+/// ERROR_AP_HANDLE - buffer or argv is NULL or argv_size less than 1
+int argsparse_tokenize(char* buffer, char** argv, int argv_size);
+
+////////////
+// Images //
+////////////
+
+// Arguments and their values as one position independent block, for
+// handing a parse over to another process without parsing again. The
+// image is in native byte order and rejected by hosts of another one.
+
+/// @brief Write the global handle image
+/// @see argsparse_ctx_serialize
+size_t argsparse_serialize(void* buffer, size_t size);
+
+/// @brief Write the global handle image to fd
+/// @see argsparse_ctx_serialize_fd
+ARG_ERROR argsparse_serialize_fd(int fd);
+
+/// @brief Create the global handle from an image
+/// @see argsparse_ctx_deserialize
+/// @return
+/// ERROR_AP_NONE(0) - success
+///
+/// ERROR_AP_EXISTS - global handle already created
+///
+/// ERROR_AP_FORMAT - image is not valid or out of memory
+ARG_ERROR argsparse_deserialize(const void* image, size_t size);
+
+/// @brief Create the global handle from an image in fd
+/// @see argsparse_ctx_deserialize_fd
+/// @return as argsparse_deserialize
+ARG_ERROR argsparse_deserialize_fd(int fd);
+
+/// @brief Registers the arguments of a schema on a cache miss
+/// @param handle empty handle to add the arguments to
+/// @param context as given to argsparse_create_cached
+/// @return ERROR_AP_NONE or an error to fail the creation with
+typedef ARG_ERROR (*argsparse_build_fn)(ARG_DATA_HANDLE handle, void* context);
+
+/// @brief Create the global handle from a schema cache
+/// @see argsparse_ctx_create_cached
+/// @return
+/// ERROR_AP_NONE(0) - success
+///
+/// ERROR_AP_EXISTS - global handle already created
+///
+/// ERROR_AP_MEMORY - out of memory
+///
+/// other - error returned by build
+ARG_ERROR argsparse_create_cached(const char* title, const char* path, uint64_t key, argsparse_build_fn build, void* context);
+
+/// @brief Write image of the arguments and values into buffer. Flag
+/// pointers are not kept, their current values are.
+/// @param buffer NULL or size bytes, written only when the image fits
+/// @return image size, 0 when handle is NULL or the arguments exceed
+/// the 4 GiB image limit
+size_t argsparse_ctx_serialize(ARG_DATA_HANDLE handle, void* buffer, size_t size);
+
+/// @brief Write image to fd at its current position, e.g. a memfd or
+/// pipe passed on to a child process
+/// @return
+/// ERROR_AP_NONE(0) - success
+///
+/// ERROR_AP_FILE - writing failed
+///
+/// ERROR_AP_MEMORY - out of memory
+ARG_ERROR argsparse_ctx_serialize_fd(ARG_DATA_HANDLE handle, int fd);
+
+/// @brief Create handle from an image without copying, names, descriptions
+/// and string values point into image which has to outlive the handle.
+/// Values and parse sources are as serialized, flags set the handle own
+/// storage.
+/// @return handle or NULL when the image is not valid or out of memory
+ARG_DATA_HANDLE argsparse_ctx_deserialize(const void* image, size_t size);
+
+/// @brief Create handle from the whole image in fd, mapped where
+/// possible and read otherwise. The handle owns the mapping, fd stays
+/// open and owned by the caller.
+/// @return handle or NULL when fd cannot be read, the image is not valid
+/// or out of memory
+ARG_DATA_HANDLE argsparse_ctx_deserialize_fd(int fd);
+
+/// @brief Create frozen handle from the schema cache at path, skipping
+/// registration. When the file is missing, damaged or was written for
+/// another key, build registers the arguments and the cache is rewritten.
+/// @param title as argsparse_ctx_create
+/// @param key hash or version of the schema definition, change it with
+/// the arguments build adds
+/// @param build adds the arguments on a cache miss
+/// @return handle or NULL when out of memory or build failed
+/// @note A cached schema does not keep flag pointers, flags set their own
+/// storage. Writing the cache is best effort, failing it does not fail
+/// the creation.
+ARG_DATA_HANDLE argsparse_ctx_create_cached(const char* title, const char* path, uint64_t key, argsparse_build_fn build, void* context);
+
 #if defined( __cplusplus )
 }
 #endif
\ No newline at end of file
@@ -0,0 +1,589 @@
+/**
+ * @file argsparse.hpp
+ * @author Tuomas Lahtinen (tuomas123lahtinen@gmail.com)
+ * @brief Compile-time schema front end, header only, C++17
+ *
+ * A schema is declared once as a constexpr list of options:
+ *
+ *     static constexpr auto kSchema = argsparse::make_schema(
+ *         argsparse::int_option("integer", "This is an integer", 0),
+ *         argsparse::flag_option("flag", "This is a flag", 1));
+ *
+ *     argsparse::parser<kSchema> args;
+ *     args.parse(argc, argv);
+ *     int value = ARGSPARSE_GET(args, "integer");
+ *
+ * Short options, the shortopts string and a perfect hash of the names
+ * are generated by the compiler. Duplicate names or short options fail
+ * the constant evaluation of make_schema and unknown names in
+ * ARGSPARSE_GET fail to compile.
+ *
+ * @copyright Copyright (c) 2023
+ *
+ */
+
+#pragma once
+
+#include "argsparse.h"
+
+#include <array>
+#include <charconv>
+#include <cstddef>
+#include <cstdint>
+#include <cstdlib>
+#include <stdexcept>
+#include <string_view>
+#include <system_error>
+#include <type_traits>
+
+#if !defined(__cpp_lib_to_chars)
+// strtod_l for the double fallback
+#include <cerrno>
+#include <clocale>
+#include <cmath>
+#if defined(__APPLE__)
+#include <xlocale.h>
+#endif
+#endif
+
+namespace argsparse
+{
+
+/// @brief Option descriptor, use the *_option factories
+struct option
+{
+    std::string_view name;
+    std::string_view description;
+    ARG_TYPE type = ARGSPARSE_TYPE_NONE;
+    /// @brief 0 generates one the same way as the C API
+    char short_name = 0;
+    /// @brief int default or value set by a flag
+    int int_value = 0;
+    double double_value = 0.0;
+    std::string_view string_value;
+};
+
+constexpr option int_option(std::string_view name, std::string_view description, int value, char short_name = 0)
+{
+    return option{ name, description, ARGSPARSE_TYPE_INT, short_name, value, 0.0, {} };
+}
+
+constexpr option double_option(std::string_view name, std::string_view description, double value, char short_name = 0)
+{
+    return option{ name, description, ARGSPARSE_TYPE_DOUBLE, short_name, 0, value, {} };
+}
+
+constexpr option string_option(std::string_view name, std::string_view description, std::string_view value, char short_name = 0)
+{
+    return option{ name, description, ARGSPARSE_TYPE_STRING, short_name, 0, 0.0, value };
+}
+
+/// @brief Flag setting value when present, like the C API it gets no
+/// generated short option
+constexpr option flag_option(std::string_view name, std::string_view description, int value, char short_name = 0)
+{
+    return option{ name, description, ARGSPARSE_TYPE_FLAG, short_name, value, 0.0, {} };
+}
+
+constexpr option help_option()
+{
+    return option{ "help", "Print this message", ARGSPARSE_TYPE_NONE, 0, 0, 0.0, {} };
+}
+
+namespace detail
+{
+
+constexpr uint32_t hash(std::string_view key, uint32_t seed)
+{
+    uint32_t h = 2166136261u ^ (seed * 0x9E3779B9u);
+    for (char c : key)
+    {
+        h ^= static_cast<unsigned char>(c);
+        h *= 16777619u;
+    }
+    return h;
+}
+
+constexpr std::size_t table_size(std::size_t count)
+{
+    std::size_t size = 2;
+    while (size < count * 2)
+    {
+        size *= 2;
+    }
+    return size;
+}
+
+constexpr bool takes_value(ARG_TYPE type)
+{
+    return type != ARGSPARSE_TYPE_NONE && type != ARGSPARSE_TYPE_FLAG;
+}
+
+} // namespace detail
+
+/// @brief Compile-time tables of N options
+template <std::size_t N>
+struct schema
+{
+    static constexpr std::size_t size = N;
+    static constexpr std::size_t buckets = N ? N : 1;
+    static constexpr std::size_t slots = detail::table_size(N);
+
+    std::array<option, N> options{};
+    /// @brief same format as argsparse_get_shortopts()
+    std::array<char, 2 * N + 1> shortopts{};
+    /// @brief short option character to option index, -1 when unused
+    std::array<int, 256> short_map{};
+    /// @brief per bucket seed of the second level hash
+    std::array<uint32_t, buckets> displacement{};
+    /// @brief collision free name table of option indices, -1 when empty
+    std::array<int, slots> table{};
+
+    /// @brief Option index by exact name
+    /// @return index or -1
+    constexpr int find(std::string_view name) const
+    {
+        uint32_t seed = displacement[detail::hash(name, 0) % buckets];
+        int idx = table[detail::hash(name, seed) & (slots - 1)];
+        return (idx >= 0 && options[idx].name == name) ? idx : -1;
+    }
+
+    /// @brief Option index by short option
+    /// @return index or -1
+    constexpr int find_short(char c) const
+    {
+        return short_map[static_cast<unsigned char>(c)];
+    }
+
+    /// @brief Option index by exact name, unknown names do not compile
+    /// in constant expressions and throw otherwise
+    constexpr std::size_t index(std::string_view name) const
+    {
+        int idx = find(name);
+        if (idx < 0)
+        {
+            throw std::invalid_argument("argsparse: unknown option name");
+        }
+        return static_cast<std::size_t>(idx);
+    }
+};
+
+namespace detail
+{
+
+template <std::size_t N>
+constexpr void assign_short_options(schema<N>& s)
+{
+    bool used[256] = {};
+    for (auto& idx : s.short_map)
+    {
+        idx = -1;
+    }
+
+    // explicit short options are reserved before generating
+    for (std::size_t i = 0; i < N; i++)
+    {
+        unsigned char c = static_cast<unsigned char>(s.options[i].short_name);
+        if (c == 0)
+            continue;
+        if (c == ':' || used[c])
+            throw std::invalid_argument("argsparse: duplicate or invalid short option");
+        used[c] = true;
+    }
+
+    std::size_t length = 0;
+    for (std::size_t i = 0; i < N; i++)
+    {
+        option& opt = s.options[i];
+        if (opt.short_name == 0 && opt.type != ARGSPARSE_TYPE_FLAG)
+        {
+            // first unused character of the name, then 'a'..'z' without 'j'
+            for (char c : opt.name)
+            {
+                if (c != ':' && !used[static_cast<unsigned char>(c)])
+                {
+                    opt.short_name = c;
+                    break;
+                }
+            }
+            for (char c = 'a'; opt.short_name == 0 && c <= 'z'; c++)
+            {
+                if (c != 'j' && !used[static_cast<unsigned char>(c)])
+                {
+                    opt.short_name = c;
+                }
+            }
+            used[static_cast<unsigned char>(opt.short_name)] = true;
+        }
+
+        if (opt.short_name != 0)
+        {
+            s.short_map[static_cast<unsigned char>(opt.short_name)] = static_cast<int>(i);
+            s.shortopts[length++] = opt.short_name;
+            if (takes_value(opt.type))
+            {
+                s.shortopts[length++] = ':';
+            }
+        }
+    }
+    s.shortopts[length] = '\0';
+}
+
+/// @brief hash and displace: buckets by first level hash, largest
+/// first, each searching a seed that places all its names in free slots
+template <std::size_t N>
+constexpr void build_perfect_hash(schema<N>& s)
+{
+    constexpr std::size_t buckets = schema<N>::buckets;
+    constexpr std::size_t mask = schema<N>::slots - 1;
+
+    std::size_t bucket_of[N ? N : 1] = {};
+    std::size_t bucket_size[buckets] = {};
+    std::size_t order[buckets] = {};
+    for (auto& idx : s.table)
+    {
+        idx = -1;
+    }
+    for (std::size_t i = 0; i < N; i++)
+    {
+        bucket_of[i] = hash(s.options[i].name, 0) % buckets;
+        bucket_size[bucket_of[i]]++;
+    }
+    for (std::size_t b = 0; b < buckets; b++)
+    {
+        order[b] = b;
+    }
+    for (std::size_t i = 0; i < buckets; i++)
+    {
+        for (std::size_t j = i + 1; j < buckets; j++)
+        {
+            if (bucket_size[order[j]] > bucket_size[order[i]])
+            {
+                std::size_t tmp = order[i];
+                order[i] = order[j];
+                order[j] = tmp;
+            }
+        }
+    }
+
+    for (std::size_t o = 0; o < buckets && bucket_size[order[o]] > 0; o++)
+    {
+        std::size_t bucket = order[o];
+        uint32_t seed = 1;
+        for (;; seed++)
+        {
+            if (seed > 1000000)
+                throw std::logic_error("argsparse: perfect hash not found");
+
+            bool placed = true;
+            for (std::size_t i = 0; placed && i < N; i++)
+            {
+                if (bucket_of[i] != bucket)
+                    continue;
+
+                std::size_t slot = hash(s.options[i].name, seed) & mask;
+                placed = s.table[slot] < 0;
+                // names of the same bucket must not collide either
+                for (std::size_t j = 0; placed && j < i; j++)
+                {
+                    placed = bucket_of[j] != bucket || (hash(s.options[j].name, seed) & mask) != slot;
+                }
+            }
+            if (placed)
+                break;
+        }
+
+        s.displacement[bucket] = seed;
+        for (std::size_t i = 0; i < N; i++)
+        {
+            if (bucket_of[i] == bucket)
+            {
+                s.table[hash(s.options[i].name, seed) & mask] = static_cast<int>(i);
+            }
+        }
+    }
+}
+
+} // namespace detail
+
+/// @brief Build the schema tables, evaluate as constexpr
+template <typename... Options>
+constexpr auto make_schema(const Options&... options)
+{
+    static_assert((std::is_same_v<Options, option> && ...), "make_schema takes argsparse::option values");
+    constexpr std::size_t N = sizeof...(Options);
+
+    schema<N> s{};
+    s.options = { options... };
+    for (std::size_t i = 0; i < N; i++)
+    {
+        if (s.options[i].name.empty())
+            throw std::invalid_argument("argsparse: empty option name");
+
+        for (std::size_t j = 0; j < i; j++)
+        {
+            if (s.options[i].name == s.options[j].name)
+                throw std::invalid_argument("argsparse: duplicate option name");
+        }
+    }
+    detail::assign_short_options(s);
+    detail::build_perfect_hash(s);
+    return s;
+}
+
+/// @brief Parsed values of a schema declared with static storage duration
+template <const auto& Schema>
+class parser
+{
+public:
+    using schema_type = std::decay_t<decltype(Schema)>;
+    static constexpr const schema_type& definition = Schema;
+    static constexpr std::size_t size = schema_type::size;
+
+    parser()
+    {
+        reset();
+    }
+
+    /// @brief Restore defaults and clear parsed
+    void reset()
+    {
+        for (std::size_t i = 0; i < size; i++)
+        {
+            const option& opt = Schema.options[i];
+            values_[i].int_value = opt.type == ARGSPARSE_TYPE_FLAG ? 0 : opt.int_value;
+            values_[i].double_value = opt.double_value;
+            values_[i].string_value = opt.string_value;
+            parsed_[i] = false;
+        }
+    }
+
+    /// @brief Parse argv with the same syntax as argsparse_parse_args,
+    /// string values reference argv. Never prints nor exits, help is
+    /// reported through parsed().
+    /// @return parsed option count or
+    ///
+    /// ERROR_AP_UNKNOWN - unknown or ambiguous option, missing or unexpected value
+    ///
+    /// ERROR_AP_FORMAT - option value is not valid for its type
+    ///
+    /// ERROR_AP_RANGE - option value does not fit its type
+    int parse(int argc, char* const* argv)
+    {
+        int count = 0;
+        bool operands_only = false;
+        for (int i = 1; i < argc; i++)
+        {
+            std::string_view token(argv[i]);
+            if (operands_only || token.size() < 2 || token[0] != '-')
+                continue;
+
+            if (token == "--")
+            {
+                operands_only = true;
+            }
+            else if (token[1] == '-')
+            {
+                std::string_view name = token.substr(2);
+                std::size_t equals = name.find('=');
+                int idx = find_long(name.substr(0, equals));
+                if (idx < 0)
+                    return ERROR_AP_UNKNOWN;
+
+                if (!detail::takes_value(Schema.options[idx].type))
+                {
+                    if (equals != std::string_view::npos)
+                        return ERROR_AP_UNKNOWN;
+                    set(idx, {});
+                }
+                else if (equals != std::string_view::npos)
+                {
+                    ARG_ERROR err = set(idx, name.substr(equals + 1));
+                    if (err)
+                        return err;
+                }
+                else if (i + 1 < argc)
+                {
+                    ARG_ERROR err = set(idx, argv[++i]);
+                    if (err)
+                        return err;
+                }
+                else
+                {
+                    return ERROR_AP_UNKNOWN;
+                }
+                count++;
+            }
+            else
+            {
+                for (std::size_t c = 1; c < token.size(); c++)
+                {
+                    int idx = Schema.find_short(token[c]);
+                    if (idx < 0)
+                        return ERROR_AP_UNKNOWN;
+
+                    if (detail::takes_value(Schema.options[idx].type))
+                    {
+                        // "-xVALUE" or "-x VALUE"
+                        std::string_view value = token.substr(c + 1);
+                        if (value.empty())
+                        {
+                            if (i + 1 >= argc)
+                                return ERROR_AP_UNKNOWN;
+                            value = argv[++i];
+                        }
+                        ARG_ERROR err = set(idx, value);
+                        if (err)
+                            return err;
+                        count++;
+                        break;
+                    }
+                    set(idx, {});
+                    count++;
+                }
+            }
+        }
+        return count;
+    }
+
+    /// @brief Typed value: int for int and flag options, double,
+    /// std::string_view, bool parsed for help
+    template <std::size_t I>
+    auto get() const
+    {
+        static_assert(I < size, "option index out of range");
+        constexpr ARG_TYPE type = Schema.options[I].type;
+        if constexpr (type == ARGSPARSE_TYPE_INT || type == ARGSPARSE_TYPE_FLAG)
+            return values_[I].int_value;
+        else if constexpr (type == ARGSPARSE_TYPE_DOUBLE)
+            return values_[I].double_value;
+        else if constexpr (type == ARGSPARSE_TYPE_STRING)
+            return values_[I].string_value;
+        else
+            return parsed_[I];
+    }
+
+    template <std::size_t I>
+    bool parsed() const
+    {
+        static_assert(I < size, "option index out of range");
+        return parsed_[I];
+    }
+
+private:
+    struct value
+    {
+        int int_value;
+        double double_value;
+        std::string_view string_value;
+    };
+
+    /// @brief exact match first, then unique prefix
+    static int find_long(std::string_view name)
+    {
+        int idx = Schema.find(name);
+        if (idx < 0 && !name.empty())
+        {
+            for (std::size_t i = 0; i < size; i++)
+            {
+                if (Schema.options[i].name.substr(0, name.size()) == name)
+                {
+                    if (idx >= 0)
+                        return -1;
+                    idx = static_cast<int>(i);
+                }
+            }
+        }
+        return idx;
+    }
+
+#if !defined(__cpp_lib_to_chars)
+    /// @brief strtod in the "C" locale whatever setlocale() says, like the C API
+    static double strtod_c(const char* text, char** end)
+    {
+#if defined(_MSC_VER)
+        static const _locale_t c_locale = _create_locale(LC_NUMERIC, "C");
+        return _strtod_l(text, end, c_locale);
+#else
+        static const locale_t c_locale = newlocale(LC_NUMERIC_MASK, "C", locale_t(0));
+        return strtod_l(text, end, c_locale);
+#endif
+    }
+#endif
+
+    /// @brief from_chars takes no '+' sign
+    static const char* skip_plus(std::string_view text)
+    {
+        bool plus = text.size() > 1 && text[0] == '+' && text[1] != '-';
+        return text.data() + plus;
+    }
+
+    ARG_ERROR set(int idx, std::string_view text)
+    {
+        const option& opt = Schema.options[idx];
+        value& slot = values_[idx];
+        const char* last = text.data() + text.size();
+        switch (opt.type)
+        {
+            case ARGSPARSE_TYPE_INT:
+            {
+                // the stored value only changes on success, as in the C API
+                int parsed = 0;
+                auto result = std::from_chars(skip_plus(text), last, parsed);
+                if (result.ec == std::errc::result_out_of_range)
+                    return ERROR_AP_RANGE;
+                if (result.ec != std::errc() || result.ptr != last || text.empty())
+                    return ERROR_AP_FORMAT;
+                slot.int_value = parsed;
+                break;
+            }
+            case ARGSPARSE_TYPE_DOUBLE:
+            {
+                double parsed = 0.0;
+#if defined(__cpp_lib_to_chars)
+                auto result = std::from_chars(skip_plus(text), last, parsed);
+                if (result.ec == std::errc::result_out_of_range)
+                    return ERROR_AP_RANGE;
+                if (result.ec != std::errc() || result.ptr != last || text.empty())
+                    return ERROR_AP_FORMAT;
+#else
+                // argv elements and "--name=value" tails are NUL-terminated
+                char* end = nullptr;
+                errno = 0;
+                parsed = strtod_c(text.data(), &end);
+                if (end != last || text.empty())
+                    return ERROR_AP_FORMAT;
+                if (errno == ERANGE && std::isinf(parsed))
+                    return ERROR_AP_RANGE;
+#endif
+                slot.double_value = parsed;
+                break;
+            }
+            case ARGSPARSE_TYPE_STRING:
+                if (text.empty())
+                    return ERROR_AP_FORMAT;
+                slot.string_value = text;
+                break;
+            case ARGSPARSE_TYPE_FLAG:
+                slot.int_value = opt.int_value;
+                break;
+            default:
+                break;
+        }
+        parsed_[idx] = true;
+        return ERROR_AP_NONE;
+    }
+
+    std::array<value, size> values_{};
+    std::array<bool, size> parsed_{};
+};
+
+} // namespace argsparse
+
+/// @brief Typed value by name, unknown names fail to compile
+#define ARGSPARSE_GET(parser, name) \
+    (parser).template get<std::decay_t<decltype(parser)>::definition.index(name)>()
+
+/// @brief Parsed state by name, unknown names fail to compile
+#define ARGSPARSE_PARSED(parser, name) \
+    (parser).template parsed<std::decay_t<decltype(parser)>::definition.index(name)>()
@@ -0,0 +1,32 @@
+#ifndef ARENA_H
+#define ARENA_H
+
+#include <stddef.h>
+
+typedef struct _arena_block
+{
+    struct _arena_block* next;
+    size_t size;
+    size_t used;
+} arena_block_t;
+
+/// @brief Bump allocator, blocks grow geometrically and are
+/// released all at once
+typedef struct _arena
+{
+    arena_block_t* head;
+    /// @brief last allocation, the only one that can be given back
+    void* last;
+} arena_t;
+
+/// @brief Allocate zeroed memory aligned for any argument type
+/// @return pointer or NULL when out of memory
+void* arena_alloc(arena_t* arena, size_t size);
+
+/// @brief Give back the memory when ptr is the most recent allocation
+void arena_rollback(arena_t* arena, void* ptr);
+
+/// @brief Release all blocks, the arena may itself live inside one
+void arena_release(arena_t* arena);
+
+#endif
@@ -0,0 +1,34 @@
+#ifndef CONFIG_H
+#define CONFIG_H
+
+#include <stddef.h>
+
+/// @brief One "key = value" line of a configuration file
+typedef struct _config_entry
+{
+    /// @brief not NUL-terminated
+    const char* key;
+    size_t key_length;
+    /// @brief NUL-terminated in place, unquoted, NULL when the line has no '='
+    char* value;
+    int line;
+} config_entry_t;
+
+/// @brief Single pass reader of INI style text. Empty lines, '#' and
+/// ';' comments and [section] headers are skipped, keys and values are
+/// trimmed and a value in matching quotes is unquoted.
+typedef struct _config_reader
+{
+    char* next;
+    char* end;
+    int line;
+} config_reader_t;
+
+/// @brief Read text[0..length), text[length] must be writable
+void config_init(config_reader_t* reader, char* text, size_t length);
+
+/// @brief Next entry
+/// @return 1 with entry set or 0 when the text is exhausted
+int config_next(config_reader_t* reader, config_entry_t* entry);
+
+#endif
@@ -0,0 +1,38 @@
+#ifndef FILE_MAP_H
+#define FILE_MAP_H
+
+#include <stddef.h>
+
+/// @brief Private writable view of a whole file, memory-mapped where
+/// possible, otherwise read into memory. data[size] is always a
+/// writable '\0' so the contents can be tokenized in place.
+typedef struct _file_map
+{
+    char* data;
+    size_t size;
+    /// @brief length of the mapping, 0 when data is malloc'd
+    size_t mapped;
+    /// @brief list link for the owner
+    struct _file_map* next;
+} file_map_t;
+
+/// @brief Map or read file at path
+/// @return map or NULL when the file cannot be read
+file_map_t* file_map_open(const char* path);
+
+/// @brief Map or read the whole file behind an open descriptor,
+/// fd stays open and owned by the caller. Pipes are read to their end.
+/// @return map or NULL when the descriptor cannot be read
+file_map_t* file_map_open_fd(int fd);
+
+/// @brief Unmap and free, null-safe
+void file_map_close(file_map_t* map);
+
+/// @brief Close every map of a list linked through next
+void file_map_close_all(file_map_t* list);
+
+/// @brief Whether p points into the contents or at the terminator of a
+/// map of list
+int file_map_contains(const file_map_t* list, const char* p);
+
+#endif
@@ -0,0 +1,85 @@
+#ifndef FREEZE_H
+#define FREEZE_H
+
+#include "argsparse.h"
+
+#include <stddef.h>
+#include <stdint.h>
+
+/// @brief Parse-time view of one argument
+typedef struct _frozen_option
+{
+    ARG_ARGUMENT_HANDLE argument;
+    const char* name;
+    uint32_t length;
+    uint32_t hash;
+    int takes_value;
+} frozen_option_t;
+
+/// @brief Name index slot, option is -1 when empty
+typedef struct _frozen_slot
+{
+    uint32_t hash;
+    int32_t option;
+} frozen_slot_t;
+
+/// @brief Radix trie node. The names under a node are a range of the
+/// sorted option indices, the children of a node are consecutive nodes.
+typedef struct _frozen_node
+{
+    /// @brief edge label into the node, points into an option name
+    const char* label;
+    uint32_t label_length;
+    /// @brief name length at the end of the label
+    uint32_t depth;
+    /// @brief option named exactly by the path, -1 when none
+    int32_t exact;
+    /// @brief range [lo, hi) of sorted under the node, exact included
+    uint32_t lo;
+    uint32_t hi;
+    uint32_t first_child;
+    uint32_t child_count;
+} frozen_node_t;
+
+/// @brief Read-only image built by freeze, allocated as one block
+/// with the arrays following the header
+typedef struct _frozen_schema
+{
+    int count;
+    uint32_t slot_mask;
+    /// @brief short option character to option index, -1 when unused
+    int32_t short_map[256];
+    /// @brief options in insertion order
+    frozen_option_t* options;
+    frozen_slot_t* slots;
+    /// @brief values at freeze time, flags store the pointed int in intvalue
+    ARG_VALUE* defaults;
+    /// @brief option indices in name order
+    int32_t* sorted;
+    /// @brief long option trie, root first
+    frozen_node_t* nodes;
+    /// @brief first label byte of each node, scanned to pick a child
+    unsigned char* node_bytes;
+    uint32_t node_count;
+} frozen_schema_t;
+
+/// @brief Build the image of the handle arguments
+/// @return image or NULL when out of memory
+frozen_schema_t* frozen_schema_create(ARG_DATA_HANDLE handle);
+
+/// @brief Exact name lookup
+ARG_ARGUMENT_HANDLE frozen_find_name(const frozen_schema_t* schema, const char* name, size_t length);
+
+/// @brief Exact name lookup falling back to unique prefix, found in one
+/// walk of the trie taking the length of name
+/// @param ambiguous receives the number of names starting with name
+/// when there are several and none of them is name, otherwise 0
+ARG_ARGUMENT_HANDLE frozen_find_prefix(const frozen_schema_t* schema, const char* name, size_t length, int* ambiguous);
+
+/// @brief Short option lookup
+ARG_ARGUMENT_HANDLE frozen_find_short(const frozen_schema_t* schema, int c);
+
+/// @brief Restore values from the default image and clear parsed
+void frozen_reset(const frozen_schema_t* schema);
+
+#endif
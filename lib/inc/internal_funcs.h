@@ -3,28 +3,46 @@
 
 #include "internal_types.h"
 
+#include <float.h>
 #include <stddef.h>
 
-static ARG_ERROR CheckHandle();
-static ARG_ARGUMENT_HANDLE create_argument(ARG_TYPE type, const char* name, const char* description, const ARG_VALUE* value);
-static void free_argument(ARG_ARGUMENT_HANDLE* handle);
-static HARGPARSE_ARG_LINKED free_linked_argument(HARGPARSE_ARG_LINKED arg);
+/// @brief buffer of get_argument_value_string, fits every flag, int and
+/// "%f" double
+#define VALUE_STRING_SIZE (DBL_MAX_10_EXP + 32)
 
-/// @brief Add argument moves argument ownership to handle
-/// @param handle Handle to allocated arguments structure
-/// @param argument Handle to allocated argument
+const char* intern_string(ARG_DATA_HANDLE handle, const char* source);
+/// @brief Copy value[0..length) into the copy storage of arg, which grows
+/// as needed and holds one value at a time
+/// @return NUL-terminated copy or NULL when out of memory
+const char* copy_value(ARG_ARGUMENT_HANDLE arg, const char* value, size_t length);
+/// @brief Parse decimal int from [str, end), no whitespace or trailing characters
 /// @return
-/// ERROR_AP_NONE(0) - success
+/// ERROR_AP_NONE(0) - success, out set
 ///
-/// ERROR_AP_EXISTS - argument with same name already exists
+/// ERROR_AP_FORMAT - not a decimal integer
 ///
-/// ERROR_AP_MAX_ARGS(1) - ARGSPARSE_MAX_ARGS reached, not added
-static ARG_ERROR put_argument(ARG_DATA_HANDLE handle, ARG_ARGUMENT_HANDLE* argument);
+/// ERROR_AP_RANGE - does not fit in int
+int parse_int(const char* str, const char* end, int* out);
 
-void copy_to_argument_string(char* dest, const char* source);
-int parse_value(ARG_VALUE* ref, ARG_TYPE type, const char* value);
+/// @brief Parse double from [str, end) regardless of the current locale, correctly rounded
+/// @return
+/// ERROR_AP_NONE(0) - success, out set
+///
+/// ERROR_AP_FORMAT - not a decimal floating point number, inf or nan
+///
+/// ERROR_AP_RANGE - magnitude too large for double
+///
+/// ERROR_AP_MEMORY - out of memory for the slow path or its "C" locale
+int parse_double(const char* str, const char* end, double* out);
+
+/// @brief Parse value string by the type of arg into ref, copies of
+/// strings go to the copy storage of arg
+/// @return ERROR_AP_NONE(0), ERROR_AP_FORMAT, ERROR_AP_RANGE or ERROR_AP_MEMORY
+int parse_value(ARG_DATA_HANDLE handle, ARG_ARGUMENT_HANDLE arg, ARG_VALUE* ref, const char* value);
 int set_short_option(char c, ARG_DATA_HANDLE handle, ARG_ARGUMENT_HANDLE arg);
 void generate_short_name(ARG_DATA_HANDLE handle, ARG_ARGUMENT_HANDLE arg);
 const char* get_argument_type_string(ARG_TYPE type);
+/// @brief Value of arg as text, numbers are formatted into buffer
+/// @return buffer or the string value itself
 const char* get_argument_value_string(ARG_ARGUMENT_HANDLE arg, char* buffer, size_t buflen);
 #endif
\ No newline at end of file
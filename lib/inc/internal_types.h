@@ -2,20 +2,50 @@
 #define INTERNAL_TYPES_H
 
 #include "argsparse.h"
+#include "arena.h"
+#include "file_map.h"
+#include "freeze.h"
+#include "name_index.h"
+#include "output.h"
+#include "string_pool.h"
 
-typedef struct _argparse_argument_linked
-{
-    ARG_ARGUMENT_HANDLE argument;
-    void* next;
-} t_argparse_argument_linked;
+#include <stdint.h>
+
+/// @brief every character with its ':' and the terminator
+#define SHORTOPTS_SIZE (256 * 2 + 1)
 
-typedef struct _argparse_argument_linked* HARGPARSE_ARG_LINKED;
 typedef struct _argparse_data
 {
-    char shortopts[ARGSPARSE_MAX_ARGS * 2];
+    char shortopts[SHORTOPTS_SIZE];
+    int shortopts_length;
+    /// @brief bitset of the characters taken as short options
+    uint32_t short_used[256 / 32];
+    /// @brief short option character to argument dispatch table
+    ARG_ARGUMENT_HANDLE short_map[256];
     int count;
-    HARGPARSE_ARG_LINKED arguments;
+    /// @brief arguments in insertion order, grows geometrically
+    ARG_ARGUMENT_HANDLE* arguments;
+    int capacity;
+    name_index_t names;
+    /// @brief set by freeze, no arguments can be added after
+    frozen_schema_t* frozen;
     const char* title;
+    /// @brief ARGSPARSE_FLAG_* bits
+    int flags;
+    /// @brief owns the handle itself, arguments and pooled strings
+    arena_t arena;
+    string_pool_t strings;
+    output_t output;
+    /// @brief images and schema caches the arguments point into, kept
+    /// until the handle is freed
+    file_map_t* files;
+    /// @brief response files of the last parse, parsed values point into
+    /// them. Released by the next parse and by reset.
+    file_map_t* parse_files;
+    /// @brief configuration file of the last load, released by the next one
+    file_map_t* config_files;
+    /// @brief pooled, environment variables are derived from it when set
+    const char* env_prefix;
 } argument_data_t;
 
 #endif
\ No newline at end of file
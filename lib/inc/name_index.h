@@ -0,0 +1,45 @@
+#ifndef NAME_INDEX_H
+#define NAME_INDEX_H
+
+#include "argsparse.h"
+
+#include <stddef.h>
+#include <stdint.h>
+
+/// @brief Open addressing slot, empty when value is NULL
+typedef struct _name_index_slot
+{
+    uint32_t hash;
+    uint32_t length;
+    const char* key;
+    void* value;
+} name_index_slot_t;
+
+/// @brief Linear probing hash table keyed by (not owned) name strings
+typedef struct _name_index
+{
+    name_index_slot_t* slots;
+    size_t capacity;
+    size_t count;
+} name_index_t;
+
+/// @brief FNV-1a hash of the key
+uint32_t name_hash(const char* key, size_t length);
+
+/// @brief Insert key pointing to non-NULL value, the key memory must outlive the index
+/// @return
+/// ERROR_AP_NONE(0) - success
+///
+/// ERROR_AP_EXISTS - key already indexed
+///
+/// ERROR_AP_MEMORY - growing the table failed
+ARG_ERROR name_index_insert(name_index_t* index, const char* key, size_t length, uint32_t hash, void* value);
+
+/// @brief Find value by key
+/// @return value or NULL
+void* name_index_find(const name_index_t* index, const char* key, size_t length, uint32_t hash);
+
+/// @brief Release slots
+void name_index_free(name_index_t* index);
+
+#endif
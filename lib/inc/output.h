@@ -0,0 +1,51 @@
+#ifndef OUTPUT_H
+#define OUTPUT_H
+
+#include "argsparse.h"
+#include "arena.h"
+
+#include <stddef.h>
+
+/// @brief size of the buffer allocated when the caller gives none
+#define OUTPUT_BUFFER_SIZE 4096
+
+/// @brief Text is assembled into the buffer and handed to write when
+/// flushed, when the stream changes or when the buffer is full
+typedef struct _output
+{
+    argsparse_write_fn write;
+    void* context;
+    char* buffer;
+    size_t size;
+    size_t length;
+    /// @brief ARGSPARSE_STREAM_* of the buffered text
+    int stream;
+    /// @brief internal buffer, allocated from arena on first use
+    char* internal;
+    arena_t* arena;
+} output_t;
+
+/// @brief Use a caller owned buffer or the internal one when NULL,
+/// pending text is flushed first
+void output_set_buffer(output_t* out, char* buffer, size_t size);
+
+/// @brief Select the stream, pending text of another stream is flushed
+/// @return 0 when no buffer could be allocated
+int output_stream(output_t* out, int stream);
+
+/// @brief Append length bytes of text
+void output_text(output_t* out, const char* text, size_t length);
+
+/// @brief Append NUL-terminated text
+void output_cstr(output_t* out, const char* text);
+
+/// @brief Append printf formatted text
+void output_format(output_t* out, const char* format, ...);
+
+/// @brief Hand the buffered text to write
+void output_flush(output_t* out);
+
+/// @brief Default write, stdio stdout or stderr
+void output_write_stdio(void* context, int stream, const char* text, size_t length);
+
+#endif
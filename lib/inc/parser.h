@@ -0,0 +1,76 @@
+#ifndef PARSER_H
+#define PARSER_H
+
+#include "internal_types.h"
+#include "file_map.h"
+#include "tokenizer.h"
+
+/// @brief nesting limit of @file response files
+#define PARSER_MAX_RESPONSE_DEPTH 8
+
+typedef enum _parser_token {
+    /// @brief argv exhausted
+    PARSER_END = 0,
+    /// @brief cursor argument and value (NULL when option takes none) set
+    PARSER_OPTION,
+    /// @brief cursor value is a non-option argv element
+    PARSER_OPERAND,
+    /// @brief cursor token/short_name does not match any argument
+    PARSER_ERROR_UNKNOWN,
+    /// @brief cursor token is a prefix of several long names
+    PARSER_ERROR_AMBIGUOUS,
+    /// @brief cursor argument requires a value but argv ended
+    PARSER_ERROR_MISSING_VALUE,
+    /// @brief cursor argument takes no value but got one with '='
+    PARSER_ERROR_UNEXPECTED_VALUE,
+    /// @brief cursor token is a response file nested too deeply
+    PARSER_ERROR_RESPONSE_DEPTH,
+} parser_token_e;
+
+/// @brief Per parse state replacing getopt's optind/optarg/nextchar globals
+typedef struct _parser_cursor
+{
+    char* const* argv;
+    int argc;
+    /// @brief next argv element to read
+    int index;
+    /// @brief remaining characters of a short option cluster "-abc"
+    const char* cluster;
+    /// @brief set after "--", everything else is an operand
+    int operands_only;
+    /// @brief open @file response files, innermost last
+    tokenizer_t responses[PARSER_MAX_RESPONSE_DEPTH];
+    int depth;
+    /// @brief every file read, token strings point into them
+    file_map_t* files;
+    /// @brief error met while reading the next element
+    parser_token_e failure;
+
+    /// @brief matched argument of the last PARSER_OPTION or error
+    ARG_ARGUMENT_HANDLE argument;
+    /// @brief option value or operand of the last token
+    const char* value;
+    /// @brief argv element the last token was read from
+    const char* token;
+    /// @brief short option character of the last token, 0 for long
+    int short_name;
+} parser_cursor_t;
+
+/// @brief Initialize cursor to the first element after the program name
+void parser_init(parser_cursor_t* cursor, char* const* argv, int argc);
+
+/// @brief Move the files read by the cursor to the list of owner,
+/// they have to stay until the parsed values are no longer used
+void parser_finish(parser_cursor_t* cursor, file_map_t** owner);
+
+/// @brief Read next option or operand. An "@path" element is replaced by
+/// the tokens of the file, or kept as is when the file cannot be read.
+/// @param handle read-only, safe to share between concurrent cursors
+/// @param cursor
+/// @return token type, cursor fields describe the token
+parser_token_e parser_next(ARG_DATA_HANDLE handle, parser_cursor_t* cursor);
+
+/// @brief Whether the argument consumes a value
+int parser_takes_value(ARG_ARGUMENT_HANDLE arg);
+
+#endif
@@ -0,0 +1,47 @@
+#ifndef RESULT_H
+#define RESULT_H
+
+#include "internal_types.h"
+
+#include <stdint.h>
+
+/// @brief parsed bit of argument index in the bitmap
+#define RESULT_PARSED_WORD(index) ((index) / 32)
+#define RESULT_PARSED_BIT(index) ((uint32_t)1 << ((index) % 32))
+
+/// @brief Values of one parse, allocated as one block with the value
+/// vector and the parsed bitmap following the header, both indexed by
+/// argument position. The values are 8 bytes and one bit per argument.
+typedef struct _argparse_result
+{
+    /// @brief frozen handle the result was parsed against
+    ARG_DATA_HANDLE schema;
+    int count;
+    /// @brief parsed argument count or error of the parse
+    int status;
+    ARG_VALUE* values;
+    uint32_t* parsed;
+    /// @brief response files read by the parse, string values point into them
+    file_map_t* files;
+} argument_result_t;
+
+/// @brief Result holding the frozen defaults of handle
+/// @return result or NULL when out of memory
+argument_result_t* result_create(ARG_DATA_HANDLE handle);
+
+/// @brief Restore the frozen defaults, clear parsed and release files
+void result_reset(argument_result_t* result);
+
+/// @brief Parse argv into result without output, exit or changes to handle,
+/// safe to run concurrently against the same frozen handle.
+/// @return parsed count or
+///
+/// ERROR_AP_UNKNOWN - unknown or ambiguous option, missing or unexpected value
+///
+/// ERROR_AP_FORMAT, ERROR_AP_RANGE - invalid option value
+int result_parse(ARG_DATA_HANDLE handle, argument_result_t* result, char* const* argv, int argc);
+
+/// @brief Free result and its files, null-safe
+void result_free(argument_result_t* result);
+
+#endif
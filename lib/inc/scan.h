@@ -0,0 +1,51 @@
+#ifndef SCAN_H
+#define SCAN_H
+
+#include <stddef.h>
+
+/// @brief Instruction set of the byte scans, the best one the processor
+/// supports is picked on first use
+typedef enum _scan_level {
+    SCAN_SCALAR = 0,
+    /// @brief 16 bytes at a time, always there on x86-64
+    SCAN_SSE2,
+    /// @brief 32 bytes at a time
+    SCAN_AVX2,
+} scan_level_e;
+
+typedef enum _scan_class {
+    /// @brief not an option, also "-" alone
+    SCAN_OPERAND = 0,
+    /// @brief "-x..." cluster
+    SCAN_SHORT,
+    /// @brief "--name[=value]"
+    SCAN_LONG,
+    /// @brief "--" alone, operands follow
+    SCAN_END_OF_OPTIONS,
+} scan_class_e;
+
+/// @brief Class of an argv element by its first bytes
+scan_class_e scan_classify(const char* token);
+
+/// @brief Level in use
+scan_level_e scan_level();
+
+/// @brief Use level, or the best supported below it
+/// @return level now in use
+scan_level_e scan_set_level(scan_level_e level);
+
+/// @brief strlen
+size_t scan_length(const char* text);
+
+/// @brief Length of the name part of "name=value"
+/// @return offset of the first '=' or the terminating NUL
+size_t scan_name_end(const char* text);
+
+/// @brief Length of the run of bytes the tokenizer copies as is: up to
+/// whitespace, a quote or a backslash outside quotes, up to '"' or a
+/// backslash inside double quotes and up to '\'' inside single quotes
+/// @param quote 0, '"' or '\''
+/// @return offset of the first such byte in [text, end), end - text when none
+size_t scan_plain(const char* text, const char* end, char quote);
+
+#endif
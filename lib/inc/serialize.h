@@ -0,0 +1,89 @@
+#ifndef SERIALIZE_H
+#define SERIALIZE_H
+
+#include "file_map.h"
+#include "internal_types.h"
+
+#include <stdint.h>
+
+#define IMAGE_MAGIC "ARGSPRSE"
+#define IMAGE_VERSION 1
+/// @brief reads back as another value on a host of different byte order
+#define IMAGE_BYTE_ORDER 0x01020304u
+
+#define CACHE_MAGIC "ARGSCACH"
+
+/// @brief Schema cache file, the header is followed by the image of the
+/// schema built for key
+typedef struct _cache_header
+{
+    char magic[8];
+    uint64_t key;
+} cache_header_t;
+
+/// @brief Image of the arguments and their values. Fixed size entries
+/// follow the header and NUL-terminated strings follow the entries,
+/// strings are referred to by offset from the start of the image, 0 for
+/// none. The last byte of an image is always '\0'. Native byte order and
+/// float format, no pointers.
+typedef struct _image_header
+{
+    char magic[8];
+    uint32_t version;
+    uint32_t byte_order;
+    uint32_t count;
+    /// @brief ARGSPARSE_FLAG_* of the handle
+    uint32_t flags;
+    uint32_t title;
+    uint32_t env_prefix;
+    uint64_t size;
+} image_header_t;
+
+typedef struct _image_entry
+{
+    uint32_t name;
+    uint32_t description;
+    uint32_t env;
+    /// @brief string value, 0 for NULL
+    uint32_t string;
+    int32_t type;
+    int32_t parsed;
+    int32_t name_short;
+    /// @brief value set by a flag
+    int32_t flagvalue;
+    /// @brief int and flag values
+    int64_t integer;
+    double real;
+} image_entry_t;
+
+/// @brief Write image of handle into buffer when it fits
+/// @return image size, 0 when the arguments exceed the format
+size_t image_write(ARG_DATA_HANDLE handle, void* buffer, size_t size);
+
+/// @brief Write image of handle to fd at its current position
+/// @return ERROR_AP_NONE, ERROR_AP_FILE when writing failed,
+/// ERROR_AP_RANGE when the arguments exceed the format or ERROR_AP_MEMORY
+ARG_ERROR image_write_fd(ARG_DATA_HANDLE handle, int fd);
+
+/// @brief Replace the cache file at path with the image of handle,
+/// written beside it first so that readers never see a partial file
+/// @return ERROR_AP_NONE, ERROR_AP_FILE, ERROR_AP_RANGE or ERROR_AP_MEMORY
+ARG_ERROR cache_write(ARG_DATA_HANDLE handle, const char* path, uint64_t key);
+
+/// @brief Image of a cache file
+/// @param size receives the image size
+/// @return image or NULL when map is no cache of key
+const void* cache_image(const file_map_t* map, uint64_t key, size_t* size);
+
+/// @brief Check image and copy its header out, the entries and string
+/// offsets are checked too so that reading cannot go out of bounds
+/// @return 1 when valid
+int image_validate(const void* image, size_t size, image_header_t* header);
+
+/// @brief Copy entry at index of a validated image
+void image_entry(const void* image, int index, image_entry_t* entry);
+
+/// @brief String at offset of a validated image, NULL for 0
+const char* image_string(const void* image, uint32_t offset);
+
+#endif
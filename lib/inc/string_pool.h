@@ -0,0 +1,24 @@
+#ifndef STRING_POOL_H
+#define STRING_POOL_H
+
+#include "arena.h"
+#include "name_index.h"
+
+#include <stddef.h>
+
+/// @brief Interned strings stored NUL-terminated in an arena,
+/// identical strings share storage
+typedef struct _string_pool
+{
+    arena_t* arena;
+    name_index_t strings;
+} string_pool_t;
+
+/// @brief Get pooled copy of str[0..length)
+/// @return stable pointer valid until the arena is released or NULL when out of memory
+const char* string_pool_intern(string_pool_t* pool, const char* str, size_t length);
+
+/// @brief Release the lookup table, the strings go with the arena
+void string_pool_free(string_pool_t* pool);
+
+#endif
@@ -0,0 +1,31 @@
+#ifndef THREAD_POOL_H
+#define THREAD_POOL_H
+
+#include "argsparse.h"
+
+#if defined(_MSC_VER)
+#include <windows.h>
+#endif
+
+/// @brief Relaxed atomic add on an int, evaluates to the previous value
+#if defined(_MSC_VER)
+#   define FETCH_ADD(target, value) InterlockedExchangeAdd((volatile LONG*)(target), (value))
+#else
+#   define FETCH_ADD(target, value) __atomic_fetch_add((target), (value), __ATOMIC_RELAXED)
+#endif
+
+/// @brief Task run once for every index
+typedef void (*thread_task_fn)(void* context, int index);
+
+/// @brief Number of online processors, at least 1
+int thread_pool_cpu_count();
+
+/// @brief Run task for every index in [0, count) on up to nthreads threads,
+/// the calling one included. Each thread starts on its own contiguous range
+/// and steals indices from the ranges of the others when it runs out.
+/// Returns when every index has run, the ranges of threads that failed
+/// to start are taken over by the others.
+/// @param nthreads 0 or less for thread_pool_cpu_count()
+void thread_pool_run(int count, int nthreads, thread_task_fn task, void* context);
+
+#endif
@@ -0,0 +1,27 @@
+#ifndef TOKENIZER_H
+#define TOKENIZER_H
+
+#include <stddef.h>
+
+/// @brief In-place splitter of whitespace separated, shell quoted text.
+/// Quotes and escapes are removed by moving the token text left and
+/// every token is NUL-terminated in the buffer, nothing is copied out.
+///
+/// 'single quotes' are literal, inside "double quotes" a backslash
+/// escapes '"', '\\', '$' and '`', elsewhere it escapes any character.
+typedef struct _tokenizer
+{
+    char* next;
+    char* end;
+    /// @brief set when a quote ran to the end of the text
+    int unterminated;
+} tokenizer_t;
+
+/// @brief Tokenize text[0..length), text[length] must be writable
+void tokenizer_init(tokenizer_t* tokenizer, char* text, size_t length);
+
+/// @brief Next token, stable until the buffer is released
+/// @return NUL-terminated token or NULL when the text is exhausted
+char* tokenizer_next(tokenizer_t* tokenizer);
+
+#endif
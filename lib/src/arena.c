@@ -0,0 +1,70 @@
+#include "arena.h"
+
+#include <stdlib.h>
+#include <string.h>
+
+#define ARENA_MIN_BLOCK 4096
+#define ARENA_ALIGNMENT 16
+
+static size_t align_up(size_t size)
+{
+    return (size + ARENA_ALIGNMENT - 1) & ~(size_t)(ARENA_ALIGNMENT - 1);
+}
+
+static char* block_data(arena_block_t* block)
+{
+    return (char*)block + align_up(sizeof(arena_block_t));
+}
+
+void* arena_alloc(arena_t* arena, size_t size)
+{
+    size = align_up(size ? size : 1);
+    arena_block_t* block = arena->head;
+    if (block == NULL || block->size - block->used < size)
+    {
+        // double the previous block to keep the block count logarithmic
+        size_t capacity = block ? block->size * 2 : ARENA_MIN_BLOCK;
+        while (capacity < size)
+        {
+            capacity *= 2;
+        }
+
+        arena_block_t* grown = malloc(align_up(sizeof(arena_block_t)) + capacity);
+        if (grown == NULL)
+        {
+            return NULL;
+        }
+        grown->next = block;
+        grown->size = capacity;
+        grown->used = 0;
+        arena->head = block = grown;
+    }
+
+    void* ptr = block_data(block) + block->used;
+    block->used += size;
+    memset(ptr, 0, size);
+    arena->last = ptr;
+    return ptr;
+}
+
+void arena_rollback(arena_t* arena, void* ptr)
+{
+    if (ptr != NULL && ptr == arena->last)
+    {
+        arena->head->used = (size_t)((char*)ptr - block_data(arena->head));
+        arena->last = NULL;
+    }
+}
+
+void arena_release(arena_t* arena)
+{
+    arena_block_t* block = arena->head;
+    arena->head = NULL;
+    arena->last = NULL;
+    while (block)
+    {
+        arena_block_t* next = block->next;
+        free(block);
+        block = next;
+    }
+}
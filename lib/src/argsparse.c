@@ -7,17 +7,87 @@
  * 
  */
 
+#include "config.h"
 #include "internal_funcs.h"
 #include "iterate.h"
+#include "parser.h"
+#include "result.h"
+#include "serialize.h"
+#include "thread_pool.h"
+#include "tokenizer.h"
 
+#include <ctype.h>
 #include <float.h>
-#include <getopt.h>
 #include <malloc.h>
 #include <stdint.h>
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
 
+#if defined(_WIN32)
+#   define ENVIRON _environ
+#else
+extern char** environ;
+#   define ENVIRON environ
+#endif
+
+/// @brief parse_batch state shared by the threads
+typedef struct _batch
+{
+    ARG_DATA_HANDLE handle;
+    char* const* const* argv_list;
+    ARG_RESULT_HANDLE* results;
+    volatile int succeeded;
+} batch_t;
+
+static ARG_ERROR CheckHandle();
+static void batch_parse_one(void* context, int index);
+static ARG_ARGUMENT_HANDLE create_argument(ARG_DATA_HANDLE handle, ARG_TYPE type, const char* name, const char* description, const ARG_VALUE* value);
+static void free_argument(ARG_DATA_HANDLE handle, ARG_ARGUMENT_HANDLE* href);
+static void print_parser_error(ARG_DATA_HANDLE handle, output_t* out, parser_token_e token, const parser_cursor_t* cursor);
+static ARG_ARGUMENT_HANDLE find_argument(ARG_DATA_HANDLE handle, const char* name, size_t length);
+static int boolean_value(const char* value);
+static int source_precedence(int source);
+/// @brief Set value from a configuration source unless a source of
+/// higher precedence already did
+/// @return 1 when set, 0 when skipped or a negative error
+static int set_from_source(ARG_DATA_HANDLE handle, ARG_ARGUMENT_HANDLE arg, const char* value, int source);
+/// @brief Keep the option text of a lazy parse, copied with
+/// ARGSPARSE_FLAG_COPY_STRINGS
+/// @return ERROR_AP_NONE or ERROR_AP_MEMORY
+static ARG_ERROR set_raw(ARG_DATA_HANDLE handle, ARG_ARGUMENT_HANDLE arg, const char* value);
+/// @brief Convert the option text kept by a lazy parse, null-safe
+/// @return arg
+static ARG_ARGUMENT_HANDLE convert_raw(ARG_DATA_HANDLE handle, ARG_ARGUMENT_HANDLE arg);
+/// @return id of the argument just added or error
+static int added_id(ARG_DATA_HANDLE handle, ARG_ERROR error);
+/// @brief Argument of id with its value converted, NULL when out of range
+static ARG_ARGUMENT_HANDLE argument_at(ARG_DATA_HANDLE handle, int id);
+/// @brief Convert every value still kept as option text
+static void convert_all_raw(ARG_DATA_HANDLE handle);
+/// @brief Load the schema cache at path or build and write it
+/// @param out receives the frozen handle on success
+static ARG_ERROR create_cached(const char* title, const char* path, uint64_t key, argsparse_build_fn build, void* context, ARG_DATA_HANDLE* out);
+/// @brief Add the arguments of a validated image, strings point into image
+static ARG_ERROR restore_arguments(ARG_DATA_HANDLE handle, const void* image, const image_header_t* header);
+/// @brief prefix followed by name in upper case, other than letters and digits as '_'
+static void derive_env_name(char* variable, const char* prefix, size_t prefix_length, const char* name);
+/// @brief Close the maps of list, values still pointing into them are
+/// copied to their arguments first. The maps move to the files kept until
+/// free when a copy fails.
+static void release_files(ARG_DATA_HANDLE handle, file_map_t** list);
+
+/// @brief Add argument moves argument ownership to handle
+/// @param handle Handle to allocated arguments structure
+/// @param argument Handle to allocated argument
+/// @return
+/// ERROR_AP_NONE(0) - success
+///
+/// ERROR_AP_EXISTS - argument with same name already exists
+///
+/// ERROR_AP_MEMORY - growing the storage failed, not added
+static ARG_ERROR put_argument(ARG_DATA_HANDLE handle, ARG_ARGUMENT_HANDLE* argument);
+
 ARG_DATA_HANDLE g_handle = NULL;
 
 ARG_ERROR argsparse_create(const char* title)
@@ -27,264 +97,1054 @@ ARG_ERROR argsparse_create(const char* title)
         return ERROR_AP_EXISTS;
     }
 
-    g_handle = calloc(1, sizeof(argument_data_t));
-    if (g_handle)
-    {
-        g_handle->title = title;
-        g_handle->arguments = NULL;
-    }
-    return g_handle ? ERROR_AP_NONE : ERROR_AP_MEMORY;
+    g_handle = argsparse_ctx_create(title);
+    return g_handle ? ERROR_AP_NONE : ERROR_AP_MEMORY;
+}
+
+void argsparse_free()
+{
+    argsparse_ctx_free(g_handle);
+    g_handle = NULL;
+}
+
+char* argsparse_get_shortopts()
+{
+    if (CheckHandle())
+        exit(ERROR_AP_HANDLE);
+
+    return argsparse_ctx_get_shortopts(g_handle);
+}
+
+const char* argsparse_get_title()
+{
+    if (CheckHandle())
+        exit(ERROR_AP_HANDLE);
+
+    return argsparse_ctx_get_title(g_handle);
+}
+
+ARG_ARGUMENT_HANDLE argsparse_argument_by_name(const char* name)
+{
+    if (CheckHandle())
+        exit(ERROR_AP_HANDLE);
+
+    return argsparse_ctx_argument_by_name(g_handle, name);
+}
+
+ARG_ARGUMENT_HANDLE argsparse_argument_by_short_name(int shortname)
+{
+    if (CheckHandle())
+        exit(ERROR_AP_HANDLE);
+
+    return argsparse_ctx_argument_by_short_name(g_handle, shortname);
+}
+
+int argsparse_argument_count()
+{
+    if (CheckHandle())
+        exit(ERROR_AP_HANDLE);
+
+    return argsparse_ctx_argument_count(g_handle);
+}
+
+void argsparse_set_flags(int flags)
+{
+    if (CheckHandle())
+        exit(ERROR_AP_HANDLE);
+
+    argsparse_ctx_set_flags(g_handle, flags);
+}
+
+int argsparse_get_flags()
+{
+    if (CheckHandle())
+        exit(ERROR_AP_HANDLE);
+
+    return argsparse_ctx_get_flags(g_handle);
+}
+
+void argsparse_set_output(argsparse_write_fn write, void* context, char* buffer, size_t size)
+{
+    if (CheckHandle())
+        exit(ERROR_AP_HANDLE);
+
+    argsparse_ctx_set_output(g_handle, write, context, buffer, size);
+}
+
+ARG_ERROR argsparse_add(const char* name, const char* description, ARG_TYPE type, const ARG_VALUE* value)
+{
+    if (CheckHandle())
+        exit(ERROR_AP_HANDLE);
+
+    return argsparse_ctx_add(g_handle, name, description, type, value);
+}
+
+ARG_ERROR argsparse_add_help()
+{
+    if (CheckHandle())
+        exit(ERROR_AP_HANDLE);
+
+    return argsparse_ctx_add_help(g_handle);
+}
+
+ARG_ERROR argsparse_add_int(const char* name, const char* description, int value)
+{
+    if (CheckHandle())
+        exit(ERROR_AP_HANDLE);
+
+    return argsparse_ctx_add_int(g_handle, name, description, value);
+}
+
+ARG_ERROR argsparse_add_double(const char* name, const char* description, double value)
+{
+    if (CheckHandle())
+        exit(ERROR_AP_HANDLE);
+
+    return argsparse_ctx_add_double(g_handle, name, description, value);
+}
+
+ARG_ERROR argsparse_add_cstr(const char* name, const char* description, const char* value)
+{
+    if (CheckHandle())
+        exit(ERROR_AP_HANDLE);
+
+    return argsparse_ctx_add_cstr(g_handle, name, description, value);
+}
+
+ARG_ERROR argsparse_add_flag(const char* name, const char* description, int value, int* ptr_to_value)
+{
+    if (CheckHandle())
+        exit(ERROR_AP_HANDLE);
+
+    return argsparse_ctx_add_flag(g_handle, name, description, value, ptr_to_value);
+}
+
+int argsparse_parse_args(char* const *argv, int argc)
+{
+    if (CheckHandle())
+        exit(ERROR_AP_HANDLE);
+
+    return argsparse_ctx_parse_args(g_handle, argv, argc);
+}
+
+int argsparse_load_config(const char* path)
+{
+    if (CheckHandle())
+        exit(ERROR_AP_HANDLE);
+
+    return argsparse_ctx_load_config(g_handle, path);
+}
+
+void argsparse_set_env_prefix(const char* prefix)
+{
+    if (CheckHandle())
+        exit(ERROR_AP_HANDLE);
+
+    argsparse_ctx_set_env_prefix(g_handle, prefix);
+}
+
+ARG_ERROR argsparse_bind_env(const char* name, const char* variable)
+{
+    if (CheckHandle())
+        exit(ERROR_AP_HANDLE);
+
+    return argsparse_ctx_bind_env(g_handle, name, variable);
+}
+
+int argsparse_load_env(char* const* envp)
+{
+    if (CheckHandle())
+        exit(ERROR_AP_HANDLE);
+
+    return argsparse_ctx_load_env(g_handle, envp);
+}
+
+int argsparse_parse_batch(char* const* const* argv_list, int count, ARG_RESULT_HANDLE* results, int nthreads)
+{
+    if (CheckHandle())
+        exit(ERROR_AP_HANDLE);
+
+    return argsparse_ctx_parse_batch(g_handle, argv_list, count, results, nthreads);
+}
+
+ARG_ERROR argsparse_freeze()
+{
+    if (CheckHandle())
+        exit(ERROR_AP_HANDLE);
+
+    return argsparse_ctx_freeze(g_handle);
+}
+
+void argsparse_reset()
+{
+    if (CheckHandle())
+        exit(ERROR_AP_HANDLE);
+
+    argsparse_ctx_reset(g_handle);
+}
+
+void argsparse_show_usage(const char* const executable)
+{
+    if (CheckHandle())
+        exit(ERROR_AP_HANDLE);
+
+    argsparse_ctx_show_usage(g_handle, executable);
+}
+
+void argsparse_show_arguments()
+{
+    if (CheckHandle())
+        exit(ERROR_AP_HANDLE);
+
+    argsparse_ctx_show_arguments(g_handle);
+}
+
+/////////////////////
+// Context handles //
+/////////////////////
+
+ARG_DATA_HANDLE argsparse_ctx_create(const char* title)
+{
+    // the handle lives in the first block of its own arena
+    arena_t arena = {0, };
+    ARG_DATA_HANDLE handle = arena_alloc(&arena, sizeof(argument_data_t));
+    if (handle)
+    {
+        handle->arena = arena;
+        handle->strings.arena = &handle->arena;
+        handle->output.arena = &handle->arena;
+        handle->title = title;
+    }
+    return handle;
+}
+
+void argsparse_ctx_free(ARG_DATA_HANDLE handle)
+{
+    if (handle)
+    {
+        for (int i = 0; i < handle->count; i++)
+        {
+            free(handle->arguments[i]->copy);
+        }
+        free(handle->arguments);
+        name_index_free(&handle->names);
+        string_pool_free(&handle->strings);
+        free(handle->frozen);
+        file_map_close_all(handle->files);
+        file_map_close_all(handle->parse_files);
+        file_map_close_all(handle->config_files);
+        arena_t arena = handle->arena;
+        arena_release(&arena);
+    }
+}
+
+char* argsparse_ctx_get_shortopts(ARG_DATA_HANDLE handle)
+{
+    return handle ? handle->shortopts : NULL;
+}
+
+const char* argsparse_ctx_get_title(ARG_DATA_HANDLE handle)
+{
+    return handle ? handle->title : NULL;
+}
+
+ARG_ARGUMENT_HANDLE argsparse_ctx_argument_by_name(ARG_DATA_HANDLE handle, const char* name)
+{
+    if (handle == NULL || name == NULL)
+        return NULL;
+
+    return convert_raw(handle, find_argument(handle, name, strlen(name)));
+}
+
+ARG_ARGUMENT_HANDLE argsparse_ctx_argument_by_short_name(ARG_DATA_HANDLE handle, int shortname)
+{
+    if (handle == NULL)
+        return NULL;
+
+    if (handle->frozen)
+        return convert_raw(handle, frozen_find_short(handle->frozen, shortname));
+
+    return (shortname > 0 && shortname < 256) ? convert_raw(handle, handle->short_map[shortname]) : NULL;
+}
+
+int argsparse_ctx_argument_count(ARG_DATA_HANDLE handle)
+{
+    return handle ? handle->count : 0;
+}
+
+ARG_ERROR argsparse_ctx_set_flags(ARG_DATA_HANDLE handle, int flags)
+{
+    if (handle == NULL)
+        return ERROR_AP_HANDLE;
+
+    handle->flags = flags;
+    return ERROR_AP_NONE;
+}
+
+int argsparse_ctx_get_flags(ARG_DATA_HANDLE handle)
+{
+    return handle ? handle->flags : 0;
+}
+
+ARG_ERROR argsparse_ctx_set_output(ARG_DATA_HANDLE handle, argsparse_write_fn write, void* context, char* buffer, size_t size)
+{
+    if (handle == NULL)
+        return ERROR_AP_HANDLE;
+
+    output_set_buffer(&handle->output, buffer, size);
+    handle->output.write = write;
+    handle->output.context = context;
+    return ERROR_AP_NONE;
+}
+
+ARG_ERROR argsparse_ctx_add(ARG_DATA_HANDLE handle, const char* name, const char* description, ARG_TYPE type, const ARG_VALUE* value)
+{
+    if (handle == NULL)
+        return ERROR_AP_HANDLE;
+
+    ARG_ARGUMENT_HANDLE h = create_argument(handle, type, name, description, value);
+    return put_argument(handle, &h);
+}
+
+ARG_ERROR argsparse_ctx_add_help(ARG_DATA_HANDLE handle)
+{
+    if (handle == NULL)
+        return ERROR_AP_HANDLE;
+
+    ARG_ARGUMENT_HANDLE p = create_argument(handle, ARGSPARSE_TYPE_NONE, "help", "Print this message", NULL);
+    return put_argument(handle, &p);
+}
+
+ARG_ERROR argsparse_ctx_add_int(ARG_DATA_HANDLE handle, const char* name, const char* description, int value)
+{
+    if (handle == NULL)
+        return ERROR_AP_HANDLE;
+
+    ARG_VALUE argvalue;
+    argvalue.intvalue = value;
+
+    ARG_ARGUMENT_HANDLE p = create_argument(handle, ARGSPARSE_TYPE_INT, name, description, &argvalue);
+
+    return put_argument(handle, &p);
+}
+
+ARG_ERROR argsparse_ctx_add_double(ARG_DATA_HANDLE handle, const char* name, const char* description, double value)
+{
+    if (handle == NULL)
+        return ERROR_AP_HANDLE;
+
+    ARG_VALUE argvalue;
+    argvalue.doublevalue = value;
+
+    ARG_ARGUMENT_HANDLE p = create_argument(handle, ARGSPARSE_TYPE_DOUBLE, name, description, &argvalue);
+
+    return put_argument(handle, &p);
+}
+
+ARG_ERROR argsparse_ctx_add_cstr(ARG_DATA_HANDLE handle, const char* name, const char* description, const char* value)
+{
+    if (handle == NULL)
+        return ERROR_AP_HANDLE;
+
+    ARG_VALUE argvalue;
+    argvalue.stringvalue = value;
+
+    ARG_ARGUMENT_HANDLE p = create_argument(handle, ARGSPARSE_TYPE_STRING, name, description, &argvalue);
+    return put_argument(handle, &p);
+}
+
+ARG_ERROR argsparse_ctx_add_flag(ARG_DATA_HANDLE handle, const char* name, const char* description, int value, int* ptr_to_value)
+{
+    if (handle == NULL)
+        return ERROR_AP_HANDLE;
+
+    ARG_VALUE argvalue = {0, };
+    argvalue.flagptr = ptr_to_value;
+    ARG_ARGUMENT_HANDLE p = create_argument(handle, ARGSPARSE_TYPE_FLAG, name, description, &argvalue);
+    if (p)
+        p->flag_init.flagvalue = value;
+    return put_argument(handle, &p);
+}
+
+int argsparse_ctx_parse_args(ARG_DATA_HANDLE handle, char* const *argv, int argc)
+{
+    if (handle == NULL)
+        return ERROR_AP_HANDLE;
+
+    int count = 0;
+    int operands = 0;
+    // no output at all on the quiet path
+    output_t* trace = (handle->flags & ARGSPARSE_FLAG_QUIET) ? NULL : &handle->output;
+    if (trace && !output_stream(trace, ARGSPARSE_STREAM_OUT))
+        trace = NULL;
+
+    // response files of the parse before
+    release_files(handle, &handle->parse_files);
+
+    parser_cursor_t cursor;
+    parser_token_e token;
+    parser_init(&cursor, argv, argc);
+    while ((token = parser_next(handle, &cursor)) != PARSER_END)
+    {
+        ARG_ARGUMENT_HANDLE arg = cursor.argument;
+        switch (token)
+        {
+            case PARSER_OPERAND:
+                if (trace)
+                {
+                    if (operands == 0)
+                        output_cstr(trace, "non-option ARGV-elements: ");
+                    output_format(trace, "%s ", cursor.value);
+                }
+                operands++;
+                break;
+
+            case PARSER_OPTION:
+                if (arg->type == ARGSPARSE_TYPE_NONE)
+                {
+                    if (trace)
+                        output_flush(trace);
+                    argsparse_ctx_show_usage(handle, argv[0]);
+                    exit(0);
+                }
+                else if (arg->type == ARGSPARSE_TYPE_FLAG)
+                {
+                    if (trace)
+                        output_format(trace, "flag --%s\n", arg->name);
+                    *arg->value.flagptr = arg->flag_init.flagvalue;
+                    arg->parsed = ARGSPARSE_SOURCE_CMDLINE;
+                    count++;
+                }
+                else
+                {
+                    if (trace)
+                        output_format(trace, "option -%c\n", arg->name_short);
+                    int err;
+                    if (handle->flags & ARGSPARSE_FLAG_LAZY)
+                    {
+                        // converted on first lookup, which falls back to the source before
+                        if (arg->raw == NULL)
+                            arg->raw_parsed = arg->parsed;
+                        err = set_raw(handle, arg, cursor.value);
+                    }
+                    else
+                        err = parse_value(handle, arg, &arg->value, cursor.value);
+                    if (err)
+                    {
+                        if (trace)
+                        {
+                            output_stream(trace, ARGSPARSE_STREAM_ERR);
+                            output_format(trace, "%s: invalid value '%s' for option '--%s'\n", argv[0], cursor.value, arg->name);
+                            output_flush(trace);
+                        }
+                        parser_finish(&cursor, &handle->parse_files);
+                        return err;
+                    }
+                    if (trace)
+                        output_format(trace, "parsed %s\n", cursor.value);
+                    arg->parsed = ARGSPARSE_SOURCE_CMDLINE;
+                    count++;
+                }
+                break;
+
+            default:
+                if (trace)
+                {
+                    output_stream(trace, ARGSPARSE_STREAM_ERR);
+                    print_parser_error(handle, trace, token, &cursor);
+                    argsparse_ctx_show_usage(handle, argv[0]);
+                }
+                exit(1);
+        }
+    }
+
+    if (trace)
+    {
+        if (operands)
+            output_cstr(trace, "\n");
+        output_flush(trace);
+    }
+    parser_finish(&cursor, &handle->parse_files);
+
+    return count;
+}
+
+int argsparse_ctx_load_config(ARG_DATA_HANDLE handle, const char* path)
+{
+    if (handle == NULL)
+        return ERROR_AP_HANDLE;
+
+    file_map_t* file = path ? file_map_open(path) : NULL;
+    if (file == NULL)
+        return ERROR_AP_FILE;
+
+    // values are terminated in place and string values point into it,
+    // those of the load before are copied when it is released
+    release_files(handle, &handle->config_files);
+    handle->config_files = file;
+
+    output_t* out = (handle->flags & ARGSPARSE_FLAG_QUIET) ? NULL : &handle->output;
+    int count = 0;
+    config_reader_t reader;
+    config_entry_t entry;
+    config_init(&reader, file->data, file->size);
+    while (config_next(&reader, &entry))
+    {
+        ARG_ARGUMENT_HANDLE arg = find_argument(handle, entry.key, entry.key_length);
+        int err = arg ? set_from_source(handle, arg, entry.value, ARGSPARSE_SOURCE_CONFIG) : ERROR_AP_UNKNOWN;
+        if (err < 0)
+        {
+            if (out && output_stream(out, ARGSPARSE_STREAM_ERR))
+            {
+                if (err == ERROR_AP_UNKNOWN)
+                    output_format(out, "%s:%d: unknown option '%.*s'\n", path, entry.line, (int)entry.key_length, entry.key);
+                else
+                    output_format(out, "%s:%d: invalid value '%s' for option '%s'\n", path, entry.line, entry.value ? entry.value : "", arg->name);
+                output_flush(out);
+            }
+            return err;
+        }
+        count += err;
+    }
+    return count;
+}
+
+ARG_ERROR argsparse_ctx_set_env_prefix(ARG_DATA_HANDLE handle, const char* prefix)
+{
+    if (handle == NULL)
+        return ERROR_AP_HANDLE;
+
+    handle->env_prefix = prefix ? intern_string(handle, prefix) : NULL;
+    return (prefix && handle->env_prefix == NULL) ? ERROR_AP_MEMORY : ERROR_AP_NONE;
+}
+
+ARG_ERROR argsparse_ctx_bind_env(ARG_DATA_HANDLE handle, const char* name, const char* variable)
+{
+    if (handle == NULL)
+        return ERROR_AP_HANDLE;
+
+    ARG_ARGUMENT_HANDLE arg = name ? find_argument(handle, name, strlen(name)) : NULL;
+    if (arg == NULL)
+        return ERROR_AP_UNKNOWN;
+
+    arg->env = variable ? intern_string(handle, variable) : NULL;
+    return (variable && arg->env == NULL) ? ERROR_AP_MEMORY : ERROR_AP_NONE;
+}
+
+int argsparse_ctx_load_env(ARG_DATA_HANDLE handle, char* const* envp)
+{
+    if (handle == NULL)
+        return ERROR_AP_HANDLE;
+
+    // variable name to argument for the bound and prefix derived names
+    name_index_t variables = {0, };
+    char* derived = NULL;
+    size_t derived_size = 0;
+    size_t prefix_length = handle->env_prefix ? strlen(handle->env_prefix) : 0;
+    int err = ERROR_AP_NONE;
+    for (int i = 0; err == ERROR_AP_NONE && i < handle->count; i++)
+    {
+        ARG_ARGUMENT_HANDLE arg = handle->arguments[i];
+        const char* variable = arg->env;
+        size_t length = variable ? strlen(variable) : 0;
+        if (variable == NULL && handle->env_prefix && arg->type != ARGSPARSE_TYPE_NONE)
+        {
+            length = prefix_length + strlen(arg->name);
+            if (length + 1 > derived_size)
+            {
+                derived_size = (length + 1) * 2;
+                free(derived);
+                derived = malloc(derived_size);
+                if (derived == NULL)
+                {
+                    err = ERROR_AP_MEMORY;
+                    break;
+                }
+            }
+            derive_env_name(derived, handle->env_prefix, prefix_length, arg->name);
+            // pooled, loading again reuses the same names
+            variable = string_pool_intern(&handle->strings, derived, length);
+            if (variable == NULL)
+                err = ERROR_AP_MEMORY;
+        }
+        if (variable && err == ERROR_AP_NONE)
+        {
+            err = name_index_insert(&variables, variable, length, name_hash(variable, length), arg);
+            // the first argument keeps a variable bound twice
+            if (err == ERROR_AP_EXISTS)
+                err = ERROR_AP_NONE;
+        }
+    }
+    free(derived);
+
+    output_t* out = (handle->flags & ARGSPARSE_FLAG_QUIET) ? NULL : &handle->output;
+    int count = 0;
+    for (char* const* env = envp ? envp : ENVIRON; err == ERROR_AP_NONE && variables.count && env && *env; env++)
+    {
+        const char* equals = strchr(*env, '=');
+        if (equals == NULL || equals == *env)
+            continue;
+
+        size_t length = (size_t)(equals - *env);
+        ARG_ARGUMENT_HANDLE arg = name_index_find(&variables, *env, length, name_hash(*env, length));
+        if (arg == NULL)
+            continue;
+
+        int ret = set_from_source(handle, arg, equals + 1, ARGSPARSE_SOURCE_ENV);
+        if (ret < 0)
+        {
+            if (out && output_stream(out, ARGSPARSE_STREAM_ERR))
+            {
+                output_format(out, "%.*s: invalid value '%s' for option '%s'\n", (int)length, *env, equals + 1, arg->name);
+                output_flush(out);
+            }
+            err = ret;
+        }
+        count += ret > 0;
+    }
+    name_index_free(&variables);
+    return err ? err : count;
+}
+
+int argsparse_ctx_parse_batch(ARG_DATA_HANDLE handle, char* const* const* argv_list, int count, ARG_RESULT_HANDLE* results, int nthreads)
+{
+    if (handle == NULL)
+        return ERROR_AP_HANDLE;
+
+    // parsing only reads the frozen image from here on
+    ARG_ERROR err = argsparse_ctx_freeze(handle);
+    if (err)
+        return err;
+
+    batch_t batch = { handle, argv_list, results, 0 };
+    thread_pool_run(count, nthreads, batch_parse_one, &batch);
+    return batch.succeeded;
+}
+
+ARG_ERROR argsparse_ctx_freeze(ARG_DATA_HANDLE handle)
+{
+    if (handle == NULL)
+        return ERROR_AP_HANDLE;
+
+    if (handle->frozen == NULL)
+    {
+        // defaults are taken from the converted values
+        convert_all_raw(handle);
+        handle->frozen = frozen_schema_create(handle);
+        if (handle->frozen == NULL)
+            return ERROR_AP_MEMORY;
+    }
+    return ERROR_AP_NONE;
+}
+
+void argsparse_ctx_reset(ARG_DATA_HANDLE handle)
+{
+    if (handle == NULL)
+        return;
+
+    if (handle->frozen)
+        frozen_reset(handle->frozen);
+    release_files(handle, &handle->parse_files);
+}
+
+void argsparse_ctx_show_usage(ARG_DATA_HANDLE handle, const char* const executable)
+{
+    if (handle == NULL)
+        return;
+
+    convert_all_raw(handle);
+    // is there a separator?
+    const char* separator = strrchr(executable, '/') ? strrchr(executable, '/') : strrchr(executable, '\\');
+    // advance or fallback to executable
+    const char* basename = separator ? separator + 1 : executable;
+
+    output_t* out = &handle->output;
+    if (!output_stream(out, ARGSPARSE_STREAM_OUT))
+        return;
+
+    output_cstr(out, "usage: ");
+    output_cstr(out, basename);
+    char* shortopt = handle->shortopts;
+    while (*shortopt)
+    {
+        char c = *shortopt;
+        shortopt++;
+        if (c == ':')
+            continue;
+
+        char option[] = { ' ', '[', '-', c, ']' };
+        output_text(out, option, sizeof(option));
+    }
+    output_format(out, "\ntitle: %s\n", handle->title);
+
+    output_cstr(out, "optional arguments:\n");
+
+    show_data_t data = { out, 0 };
+    iterate_arguments_return_on_zero(handle, action_show_argument_usage, &data);
+    output_flush(out);
+}
+
+void argsparse_ctx_show_arguments(ARG_DATA_HANDLE handle)
+{
+    if (handle == NULL)
+        return;
+
+    convert_all_raw(handle);
+    output_t* out = &handle->output;
+    if (!output_stream(out, ARGSPARSE_STREAM_OUT))
+        return;
+
+    output_cstr(out, "argument values:\n");
+    show_data_t data = { out, 0 };
+    iterate_arguments_return_on_zero(handle, action_long_option_width, &data.width);
+    iterate_arguments_return_on_zero(handle, action_show_argument_value, &data);
+    output_flush(out);
+}
+
+/////////////
+// Results //
+/////////////
+
+ARG_RESULT_HANDLE argsparse_result_create()
+{
+    if (CheckHandle())
+        exit(ERROR_AP_HANDLE);
+
+    return argsparse_ctx_result_create(g_handle);
+}
+
+ARG_RESULT_HANDLE argsparse_ctx_result_create(ARG_DATA_HANDLE handle)
+{
+    if (handle == NULL || argsparse_ctx_freeze(handle) != ERROR_AP_NONE)
+        return NULL;
+
+    return result_create(handle);
+}
+
+void argsparse_result_free(ARG_RESULT_HANDLE result)
+{
+    result_free(result);
+}
+
+int argsparse_result_parse(ARG_RESULT_HANDLE result, char* const* argv, int argc)
+{
+    if (result == NULL)
+        return ERROR_AP_HANDLE;
+
+    result_reset(result);
+    return result_parse(result->schema, result, argv, argc);
+}
+
+int argsparse_result_status(ARG_RESULT_HANDLE result)
+{
+    return result ? result->status : ERROR_AP_HANDLE;
+}
+
+const ARG_VALUE* argsparse_result_value(ARG_RESULT_HANDLE result, const char* name)
+{
+    ARG_ARGUMENT_HANDLE arg = result && name ? find_argument(result->schema, name, strlen(name)) : NULL;
+    return arg ? &result->values[arg->index] : NULL;
+}
+
+int argsparse_result_parsed(ARG_RESULT_HANDLE result, const char* name)
+{
+    ARG_ARGUMENT_HANDLE arg = result && name ? find_argument(result->schema, name, strlen(name)) : NULL;
+    return arg ? argsparse_result_parsed_at(result, arg->index) : 0;
+}
+
+int argsparse_result_count(ARG_RESULT_HANDLE result)
+{
+    return result ? result->count : 0;
+}
+
+const ARG_VALUE* argsparse_result_value_at(ARG_RESULT_HANDLE result, int index)
+{
+    return (result && index >= 0 && index < result->count) ? &result->values[index] : NULL;
+}
+
+int argsparse_result_parsed_at(ARG_RESULT_HANDLE result, int index)
+{
+    if (result == NULL || index < 0 || index >= result->count)
+        return 0;
+
+    return (result->parsed[RESULT_PARSED_WORD(index)] & RESULT_PARSED_BIT(index)) != 0;
+}
+
+/////////
+// Ids //
+/////////
+
+int argsparse_add_int_id(const char* name, const char* description, int value)
+{
+    if (CheckHandle())
+        exit(ERROR_AP_HANDLE);
+
+    return argsparse_ctx_add_int_id(g_handle, name, description, value);
+}
+
+int argsparse_add_double_id(const char* name, const char* description, double value)
+{
+    if (CheckHandle())
+        exit(ERROR_AP_HANDLE);
+
+    return argsparse_ctx_add_double_id(g_handle, name, description, value);
+}
+
+int argsparse_add_cstr_id(const char* name, const char* description, const char* value)
+{
+    if (CheckHandle())
+        exit(ERROR_AP_HANDLE);
+
+    return argsparse_ctx_add_cstr_id(g_handle, name, description, value);
+}
+
+int argsparse_add_flag_id(const char* name, const char* description, int value, int* ptr_to_value)
+{
+    if (CheckHandle())
+        exit(ERROR_AP_HANDLE);
+
+    return argsparse_ctx_add_flag_id(g_handle, name, description, value, ptr_to_value);
+}
+
+int argsparse_argument_id(const char* name)
+{
+    if (CheckHandle())
+        exit(ERROR_AP_HANDLE);
+
+    return argsparse_ctx_argument_id(g_handle, name);
+}
+
+int argsparse_get_int(int id)
+{
+    return argsparse_ctx_get_int(g_handle, id);
+}
+
+double argsparse_get_double(int id)
+{
+    return argsparse_ctx_get_double(g_handle, id);
+}
+
+const char* argsparse_get_cstr(int id)
+{
+    return argsparse_ctx_get_cstr(g_handle, id);
+}
+
+int argsparse_get_flag(int id)
+{
+    return argsparse_ctx_get_flag(g_handle, id);
 }
 
-void argsparse_free()
+int argsparse_is_parsed(int id)
 {
-    if (g_handle)
-    {
-        HARGPARSE_ARG_LINKED next = g_handle->arguments;
-        while (next)
-        {
-            next = free_linked_argument(next);
-        }
-        free (g_handle);
-        g_handle = NULL;
-    }
+    return argsparse_ctx_is_parsed(g_handle, id);
 }
 
-char* argsparse_get_shortopts()
+int argsparse_ctx_add_int_id(ARG_DATA_HANDLE handle, const char* name, const char* description, int value)
 {
-    if (CheckHandle())
-        exit(ERROR_AP_HANDLE);
+    return added_id(handle, argsparse_ctx_add_int(handle, name, description, value));
+}
 
-    return g_handle->shortopts;
+int argsparse_ctx_add_double_id(ARG_DATA_HANDLE handle, const char* name, const char* description, double value)
+{
+    return added_id(handle, argsparse_ctx_add_double(handle, name, description, value));
 }
 
-const char* argsparse_get_title()
+int argsparse_ctx_add_cstr_id(ARG_DATA_HANDLE handle, const char* name, const char* description, const char* value)
 {
-    if (CheckHandle())
-        exit(ERROR_AP_HANDLE);
+    return added_id(handle, argsparse_ctx_add_cstr(handle, name, description, value));
+}
 
-    return g_handle->title;
+int argsparse_ctx_add_flag_id(ARG_DATA_HANDLE handle, const char* name, const char* description, int value, int* ptr_to_value)
+{
+    return added_id(handle, argsparse_ctx_add_flag(handle, name, description, value, ptr_to_value));
 }
 
-ARG_ARGUMENT_HANDLE argsparse_argument_by_name(const char* name)
+int argsparse_ctx_argument_id(ARG_DATA_HANDLE handle, const char* name)
 {
-    if (CheckHandle())
-        exit(ERROR_AP_HANDLE);
+    ARG_ARGUMENT_HANDLE arg = handle && name ? find_argument(handle, name, strlen(name)) : NULL;
+    return arg ? arg->index : ERROR_AP_UNKNOWN;
+}
 
-    return iterate_arguments_return_on_zero(g_handle, predicate_compare_name, (void*)name);
+int argsparse_ctx_get_int(ARG_DATA_HANDLE handle, int id)
+{
+    ARG_ARGUMENT_HANDLE arg = argument_at(handle, id);
+    return (arg && arg->type == ARGSPARSE_TYPE_INT) ? arg->value.intvalue : 0;
 }
 
-ARG_ARGUMENT_HANDLE argsparse_argument_by_short_name(int shortname)
+double argsparse_ctx_get_double(ARG_DATA_HANDLE handle, int id)
 {
-    if (CheckHandle())
-        exit(ERROR_AP_HANDLE);
+    ARG_ARGUMENT_HANDLE arg = argument_at(handle, id);
+    return (arg && arg->type == ARGSPARSE_TYPE_DOUBLE) ? arg->value.doublevalue : 0.0;
+}
 
-    return iterate_arguments_return_on_zero(g_handle, predicate_compare_short_name, (void*)&shortname);
+const char* argsparse_ctx_get_cstr(ARG_DATA_HANDLE handle, int id)
+{
+    ARG_ARGUMENT_HANDLE arg = argument_at(handle, id);
+    return (arg && arg->type == ARGSPARSE_TYPE_STRING) ? arg->value.stringvalue : NULL;
 }
 
-int argsparse_argument_count()
+int argsparse_ctx_get_flag(ARG_DATA_HANDLE handle, int id)
 {
-    if (CheckHandle())
-        exit(ERROR_AP_HANDLE);
+    ARG_ARGUMENT_HANDLE arg = argument_at(handle, id);
+    return (arg && arg->type == ARGSPARSE_TYPE_FLAG) ? *arg->value.flagptr : 0;
+}
 
-    int ret = 0;
-    iterate_arguments_return_on_zero(g_handle, action_count, &ret);
-    return ret;
+int argsparse_ctx_is_parsed(ARG_DATA_HANDLE handle, int id)
+{
+    ARG_ARGUMENT_HANDLE arg = argument_at(handle, id);
+    return arg ? arg->parsed : 0;
 }
 
-ARG_ERROR argsparse_add(const char* name, const char* description, ARG_TYPE type, const ARG_VALUE* value)
+///////////////
+// Tokenizer //
+///////////////
+
+int argsparse_tokenize(char* buffer, char** argv, int argv_size)
 {
-    if (CheckHandle())
-        exit(ERROR_AP_HANDLE);
+    if (buffer == NULL || argv == NULL || argv_size < 1)
+        return ERROR_AP_HANDLE;
 
-    ARG_ARGUMENT_HANDLE h = create_argument(type, name, description, value);
-    return put_argument(g_handle, &h);
+    tokenizer_t tokenizer;
+    tokenizer_init(&tokenizer, buffer, strlen(buffer));
+    int count = 0;
+    char* token;
+    while ((token = tokenizer_next(&tokenizer)) != NULL)
+    {
+        // the rest is still split and counted
+        if (count < argv_size - 1)
+            argv[count] = token;
+        count++;
+    }
+    argv[count < argv_size - 1 ? count : argv_size - 1] = NULL;
+    return tokenizer.unterminated ? ERROR_AP_FORMAT : count;
 }
 
-ARG_ERROR argsparse_add_help()
+////////////
+// Images //
+////////////
+
+size_t argsparse_serialize(void* buffer, size_t size)
 {
     if (CheckHandle())
         exit(ERROR_AP_HANDLE);
 
-    ARG_ARGUMENT_HANDLE p = create_argument(ARGSPARSE_TYPE_NONE, "help", "Print this message", NULL);
-    return put_argument(g_handle, &p);
+    return argsparse_ctx_serialize(g_handle, buffer, size);
 }
 
-ARG_ERROR argsparse_add_int(const char* name, const char* description, int value)
+ARG_ERROR argsparse_serialize_fd(int fd)
 {
     if (CheckHandle())
         exit(ERROR_AP_HANDLE);
 
-    ARG_VALUE argvalue;
-    argvalue.intvalue = value;
+    return argsparse_ctx_serialize_fd(g_handle, fd);
+}
 
-    ARG_ARGUMENT_HANDLE p = create_argument(ARGSPARSE_TYPE_INT, name, description, &argvalue);
+ARG_ERROR argsparse_deserialize(const void* image, size_t size)
+{
+    if (g_handle != NULL)
+        return ERROR_AP_EXISTS;
 
-    return put_argument(g_handle, &p);
+    g_handle = argsparse_ctx_deserialize(image, size);
+    return g_handle ? ERROR_AP_NONE : ERROR_AP_FORMAT;
 }
 
-ARG_ERROR argsparse_add_double(const char* name, const char* description, double value)
+ARG_ERROR argsparse_deserialize_fd(int fd)
 {
-    if (CheckHandle())
-        exit(ERROR_AP_HANDLE);
+    if (g_handle != NULL)
+        return ERROR_AP_EXISTS;
 
-    ARG_VALUE argvalue;
-    argvalue.doublevalue = value;
+    g_handle = argsparse_ctx_deserialize_fd(fd);
+    return g_handle ? ERROR_AP_NONE : ERROR_AP_FORMAT;
+}
 
-    ARG_ARGUMENT_HANDLE p = create_argument(ARGSPARSE_TYPE_DOUBLE, name, description, &argvalue);
+ARG_ERROR argsparse_create_cached(const char* title, const char* path, uint64_t key, argsparse_build_fn build, void* context)
+{
+    if (g_handle != NULL)
+        return ERROR_AP_EXISTS;
 
-    return put_argument(g_handle, &p);
+    return create_cached(title, path, key, build, context, &g_handle);
 }
 
-ARG_ERROR argsparse_add_cstr(const char* name, const char* description, const char* value)
+size_t argsparse_ctx_serialize(ARG_DATA_HANDLE handle, void* buffer, size_t size)
 {
-    if (CheckHandle())
-        exit(ERROR_AP_HANDLE);
-
-    ARG_VALUE argvalue;
-    copy_to_argument_string(argvalue.stringvalue, value);
+    if (handle == NULL)
+        return 0;
 
-    ARG_ARGUMENT_HANDLE p = create_argument(ARGSPARSE_TYPE_STRING, name, description, &argvalue);
-    return put_argument(g_handle, &p);
+    convert_all_raw(handle);
+    return image_write(handle, buffer, size);
 }
 
-ARG_ERROR argsparse_add_flag(const char* name, const char* description, int value, int* ptr_to_value)
+ARG_ERROR argsparse_ctx_serialize_fd(ARG_DATA_HANDLE handle, int fd)
 {
-    if (CheckHandle())
-        exit(ERROR_AP_HANDLE);
+    if (handle == NULL)
+        return ERROR_AP_HANDLE;
 
-    ARG_VALUE argvalue = {0, };
-    argvalue.flagptr = ptr_to_value;
-    ARG_ARGUMENT_HANDLE p = create_argument(ARGSPARSE_TYPE_FLAG, name, description, &argvalue);
-    p->flag_init.flagvalue = value;
-    return put_argument(g_handle, &p);
+    convert_all_raw(handle);
+    return image_write_fd(handle, fd);
 }
 
-int argsparse_parse_args(char* const *argv, int argc)
+ARG_DATA_HANDLE argsparse_ctx_deserialize(const void* image, size_t size)
 {
-    if (CheckHandle())
-        exit(ERROR_AP_HANDLE);
+    image_header_t header;
+    if (!image_validate(image, size, &header))
+        return NULL;
 
-    int count = 0;
-    // Although application call this function only once,
-    // tests call this function many times and optind has to be reset.
-    // https://github.com/skandhurkat/Getopt-for-Visual-Studio/blob/6567b18432b1b4dc0e71f71b8601df28c1ac09f8/getopt.h#L80
-    optind = 1;
-    if (argc > 1)
+    ARG_DATA_HANDLE handle = argsparse_ctx_create(image_string(image, header.title));
+    if (handle && restore_arguments(handle, image, &header) != ERROR_AP_NONE)
     {
-        int arg_count = argsparse_argument_count();
-        struct option *long_options = calloc(arg_count + 1, sizeof(struct option));
-
-        if (long_options != NULL)
-        {
-            int c = 0;
-            iterate_arguments_return_on_zero(g_handle, action_do_option_long, (void*)(long_options));
-            while(c != -1)
-            {
-                /* getopt_long stores the option index here (long_options[option_index]). */
-                int option_index = 0;
-                c = getopt_long(argc, argv,
-                                g_handle->shortopts,
-                                (const struct option *)long_options,
-                                &option_index);
-                printf("option_index(%d), optind(%d)\n", option_index, optind);
-
-                switch (c)
-                {
-                    /* Detect the end of the options. */
-                    case -1:
-                        break;
-
-                    /* opt->flag */
-                    case 0:
-                        printf ("flag -%c\n", c);
-                        count++;
-                        break;
-
-                    case 'h':
-                        argsparse_show_usage(argv[0]);
-                        exit(0);
-
-                    default:
-                        printf ("option -%c\n", c);
-                        ARG_ARGUMENT_HANDLE arg = argsparse_argument_by_short_name(c);
-                        if (arg == NULL)
-                        {
-                            printf ("invalid option -%c\n", c);
-                            argsparse_show_usage(argv[0]);
-                            exit(1);
-                        }
-                        else
-                        {
-                            int err = parse_value(&arg->value, arg->type, optarg);
-                            if (!err)
-                            {
-                                printf("parsed %s\n", optarg);
-                                arg->parsed = 1;
-                                count++;
-                            }
-                        }
-                        break;
-                }
-            }
-
-            if (optind < argc) {
-                printf("non-option ARGV-elements: ");
-                while (optind < argc)
-                    printf("%s ", argv[optind++]);
-
-                printf("\n");
-            }
-            iterate_arguments_return_on_zero(g_handle, action_mark_parsed_flags, NULL);
-            free(long_options);
-        }
+        argsparse_ctx_free(handle);
+        handle = NULL;
     }
-    return count;
+    return handle;
 }
 
-void argsparse_show_usage(const char* const executable)
+ARG_DATA_HANDLE argsparse_ctx_deserialize_fd(int fd)
 {
-    if (CheckHandle())
-        exit(ERROR_AP_HANDLE);
+    file_map_t* map = file_map_open_fd(fd);
+    if (map == NULL)
+        return NULL;
 
-    // is there a separator?
-    const char* separator = strrchr(executable, '/') ? strrchr(executable, '/') : strrchr(executable, '\\');
-    // advance or fallback to executable
-    const char* basename = separator ? separator + 1 : executable;
-
-    printf("usage: %s", basename);
-    char* shortopt = g_handle->shortopts;
-    while (*shortopt)
+    // data[size] is the map terminator, the image ends before it
+    ARG_DATA_HANDLE handle = argsparse_ctx_deserialize(map->data, map->size);
+    if (handle == NULL)
     {
-        char c = *shortopt;
-        shortopt++;
-        if (c == ':')
-            continue;
-
-        printf(" [-%c]", c);
+        file_map_close(map);
+        return NULL;
     }
-    printf("\ntitle: %s\n", g_handle->title);
-
-    printf("optional arguments:\n");
-
-    iterate_arguments_return_on_zero(g_handle, action_show_argument_usage, NULL);
+    map->next = handle->files;
+    handle->files = map;
+    return handle;
 }
 
-void argsparse_show_arguments()
+ARG_DATA_HANDLE argsparse_ctx_create_cached(const char* title, const char* path, uint64_t key, argsparse_build_fn build, void* context)
 {
-    if (CheckHandle())
-        exit(ERROR_AP_HANDLE);
-
-    printf("argument values:\n");
-    size_t width = 0;
-    iterate_arguments_return_on_zero(g_handle, action_long_option_width, &width);
-    iterate_arguments_return_on_zero(g_handle, action_show_argument_value, (void*)(uintptr_t)width);
+    ARG_DATA_HANDLE handle = NULL;
+    create_cached(title, path, key, build, context, &handle);
+    return handle;
 }
 
 ////////////////////////
 // Internal functions //
 ////////////////////////
 
+static void batch_parse_one(void* context, int index)
+{
+    batch_t* batch = context;
+    char* const* argv = batch->argv_list[index];
+    int argc = 0;
+    while (argv[argc])
+    {
+        argc++;
+    }
+
+    argument_result_t* result = result_create(batch->handle);
+    if (result && result_parse(batch->handle, result, argv, argc) >= 0)
+    {
+        FETCH_ADD(&batch->succeeded, 1);
+    }
+    batch->results[index] = result;
+}
+
 static ARG_ERROR CheckHandle()
 {
     if (g_handle == NULL)
@@ -295,20 +1155,157 @@ static ARG_ERROR CheckHandle()
     return ERROR_AP_NONE;
 }
 
-static ARG_ARGUMENT_HANDLE create_argument(ARG_TYPE type, const char* name, const char* desc, const ARG_VALUE* value)
+static ARG_ARGUMENT_HANDLE find_argument(ARG_DATA_HANDLE handle, const char* name, size_t length)
+{
+    if (handle->frozen)
+        return frozen_find_name(handle->frozen, name, length);
+
+    return name_index_find(&handle->names, name, length, name_hash(name, length));
+}
+
+/// @brief command line over environment over configuration files
+static int source_precedence(int source)
+{
+    switch (source)
+    {
+        case ARGSPARSE_SOURCE_CMDLINE:
+            return 3;
+        case ARGSPARSE_SOURCE_ENV:
+            return 2;
+        case ARGSPARSE_SOURCE_CONFIG:
+            return 1;
+        default:
+            return 0;
+    }
+}
+
+static int set_from_source(ARG_DATA_HANDLE handle, ARG_ARGUMENT_HANDLE arg, const char* value, int source)
+{
+    if (source_precedence(arg->parsed) > source_precedence(source))
+        return 0;
+
+    if (arg->type == ARGSPARSE_TYPE_NONE)
+        return ERROR_AP_FORMAT;
+
+    if (arg->type == ARGSPARSE_TYPE_FLAG)
+    {
+        int set = boolean_value(value);
+        if (set <= 0)
+            return set < 0 ? ERROR_AP_FORMAT : 0;
+        *arg->value.flagptr = arg->flag_init.flagvalue;
+    }
+    else
+    {
+        int err = parse_value(handle, arg, &arg->value, value);
+        if (err)
+            return err;
+    }
+    arg->parsed = source;
+    return 1;
+}
+
+static void derive_env_name(char* variable, const char* prefix, size_t prefix_length, const char* name)
+{
+    memcpy(variable, prefix, prefix_length);
+    variable += prefix_length;
+    for (; *name; name++)
+    {
+        *variable++ = isalnum((unsigned char)*name) ? (char)toupper((unsigned char)*name) : '_';
+    }
+    *variable = '\0';
+}
+
+/// @return 1 to set, 0 to leave unset, -1 when not a boolean
+static int boolean_value(const char* value)
+{
+    static const char* const set[] = { "", "1", "true", "yes", "on" };
+    static const char* const unset[] = { "0", "false", "no", "off" };
+    if (value == NULL)
+        return 1;
+
+    for (size_t i = 0; i < sizeof(set) / sizeof(set[0]); i++)
+    {
+        if (strcmp(value, set[i]) == 0)
+            return 1;
+    }
+    for (size_t i = 0; i < sizeof(unset) / sizeof(unset[0]); i++)
+    {
+        if (strcmp(value, unset[i]) == 0)
+            return 0;
+    }
+    return -1;
+}
+
+static void print_parser_error(ARG_DATA_HANDLE handle, output_t* out, parser_token_e token, const parser_cursor_t* cursor)
+{
+    const char* program = cursor->argv[0];
+    switch (token)
+    {
+        case PARSER_ERROR_AMBIGUOUS:
+        {
+            // name part of "--name[=value]"
+            const char* name = cursor->token + 2;
+            const char* equals = strchr(name, '=');
+            size_t length = equals ? (size_t)(equals - name) : strlen(name);
+            output_format(out, "%s: option '--%.*s' is ambiguous; possibilities:", program, (int)length, name);
+            for (int i = 0; i < handle->count; i++)
+            {
+                if (strncmp(handle->arguments[i]->name, name, length) == 0)
+                    output_format(out, " '--%s'", handle->arguments[i]->name);
+            }
+            output_cstr(out, "\n");
+        }
+        break;
+        case PARSER_ERROR_RESPONSE_DEPTH:
+            output_format(out, "%s: response files nested too deeply at '%s'\n", program, cursor->token);
+            break;
+        case PARSER_ERROR_UNEXPECTED_VALUE:
+            output_format(out, "%s: option '--%s' doesn't allow an argument\n", program, cursor->argument->name);
+            break;
+        case PARSER_ERROR_MISSING_VALUE:
+            if (cursor->short_name)
+                output_format(out, "%s: option requires an argument -- '%c'\n", program, cursor->short_name);
+            else
+                output_format(out, "%s: option '--%s' requires an argument\n", program, cursor->argument->name);
+            break;
+        default:
+            if (cursor->short_name)
+                output_format(out, "%s: invalid option -- '%c'\n", program, cursor->short_name);
+            else
+                output_format(out, "%s: unrecognized option '%s'\n", program, cursor->token);
+            break;
+    }
+}
+
+static ARG_ARGUMENT_HANDLE create_argument(ARG_DATA_HANDLE handle, ARG_TYPE type, const char* name, const char* desc, const ARG_VALUE* value)
 {
-    ARG_ARGUMENT_HANDLE p = calloc(1, sizeof(argsparse_argument_t));
-    copy_to_argument_string(p->name, name);
-    copy_to_argument_string(p->description, desc);
+    // strings first so that a rejected argument is the last allocation
+    const char* pooled_name = intern_string(handle, name);
+    const char* pooled_desc = intern_string(handle, desc);
+    // caller keeps the ownership of the given string
+    const char* pooled_value = (value && type == ARGSPARSE_TYPE_STRING) ? intern_string(handle, value->stringvalue) : NULL;
+    if (pooled_name == NULL || pooled_desc == NULL || (value && type == ARGSPARSE_TYPE_STRING && pooled_value == NULL))
+        return NULL;
+
+    ARG_ARGUMENT_HANDLE p = arena_alloc(&handle->arena, sizeof(argsparse_argument_t));
+    if (p == NULL)
+        return NULL;
+
+    p->name = pooled_name;
+    p->description = pooled_desc;
 
     p->type = type;
     if (value)
     {
         memcpy(&p->value, value, sizeof(ARG_VALUE));
-        // if no pointer given point to the unused ARG_VALUE memory
+        // if no pointer given point to the argument own storage
         if (type == ARGSPARSE_TYPE_FLAG && p->value.flagptr == NULL)
         {
-            p->value.flagptr = (int*)(&p->value.flagptr + 1);
+            p->value.flagptr = &p->flagstorage;
+        }
+        if (type == ARGSPARSE_TYPE_STRING)
+        {
+            p->value.stringvalue = pooled_value;
         }
     }
     return p;
@@ -316,65 +1313,256 @@ static ARG_ARGUMENT_HANDLE create_argument(ARG_TYPE type, const char* name, cons
 
 static ARG_ERROR put_argument(ARG_DATA_HANDLE handle, ARG_ARGUMENT_HANDLE* href)
 {
-    ARG_ARGUMENT_HANDLE exists = iterate_arguments_return_on_zero(handle, predicate_compare_name, (*href)->name);
+    if (*href == NULL)
+        return ERROR_AP_MEMORY;
+
+    if (handle->frozen)
+    {
+        free_argument(handle, href);
+        return ERROR_AP_FROZEN;
+    }
+
+    const char* name = (*href)->name;
+    size_t length = strlen(name);
+    uint32_t hash = name_hash(name, length);
+    ARG_ARGUMENT_HANDLE exists = name_index_find(&handle->names, name, length, hash);
     if (exists)
     {
         // free if not the same
         if (exists != *href)
         {
-            free_argument(href);
+            free_argument(handle, href);
         }
         return ERROR_AP_EXISTS;
     }
 
-    if (handle->count >= ARGSPARSE_MAX_ARGS)
+    if (handle->count == handle->capacity)
+    {
+        int capacity = handle->capacity ? handle->capacity * 2 : 16;
+        ARG_ARGUMENT_HANDLE* arguments = realloc(handle->arguments, capacity * sizeof(ARG_ARGUMENT_HANDLE));
+        if (arguments == NULL)
+        {
+            free_argument(handle, href);
+            return ERROR_AP_MEMORY;
+        }
+        handle->arguments = arguments;
+        handle->capacity = capacity;
+    }
+
+    if (name_index_insert(&handle->names, name, length, hash, *href) != ERROR_AP_NONE)
     {
-        free_argument(href);
-        return ERROR_AP_MAX_ARGS;
+        free_argument(handle, href);
+        return ERROR_AP_MEMORY;
     }
-    handle->count++;
-    HARGPARSE_ARG_LINKED new_link = calloc(1, sizeof(t_argparse_argument_linked));
-    new_link->argument = *href;
+    // append to keep the insertion order for iteration
+    ARG_ARGUMENT_HANDLE arg = *href;
+    arg->index = handle->count;
+    handle->arguments[handle->count++] = arg;
     *href = NULL;
 
-    generate_short_name(handle, new_link->argument);
-    if (handle->arguments)
+    int name_short = arg->name_short;
+    arg->name_short = 0;
+    // a short name restored from an image is kept when still free
+    if (name_short == 0 || set_short_option((char)name_short, handle, arg) != ERROR_AP_NONE)
+        generate_short_name(handle, arg);
+    return ERROR_AP_NONE;
+}
+
+static ARG_ERROR set_raw(ARG_DATA_HANDLE handle, ARG_ARGUMENT_HANDLE arg, const char* value)
+{
+    if ((handle->flags & ARGSPARSE_FLAG_COPY_STRINGS) == 0 || *value == '\0')
+    {
+        // empty text does not convert, no need to overwrite the copy
+        arg->raw = *value ? value : "";
+        return ERROR_AP_NONE;
+    }
+
+    arg->raw = copy_value(arg, value, strlen(value));
+    return arg->raw ? ERROR_AP_NONE : ERROR_AP_MEMORY;
+}
+
+static void release_files(ARG_DATA_HANDLE handle, file_map_t** list)
+{
+    if (*list == NULL)
+        return;
+
+    int copied = 1;
+    for (int i = 0; i < handle->count; i++)
+    {
+        ARG_ARGUMENT_HANDLE arg = handle->arguments[i];
+        if (file_map_contains(*list, arg->raw))
+            convert_raw(handle, arg);
+        if (arg->type == ARGSPARSE_TYPE_STRING && file_map_contains(*list, arg->value.stringvalue))
+        {
+            // the value outlives the file it was read from
+            const char* copy = copy_value(arg, arg->value.stringvalue, strlen(arg->value.stringvalue));
+            if (copy)
+                arg->value.stringvalue = copy;
+            else
+                copied = 0;
+        }
+    }
+
+    if (copied)
+    {
+        file_map_close_all(*list);
+    }
+    else
+    {
+        file_map_t* last = *list;
+        while (last->next)
+        {
+            last = last->next;
+        }
+        last->next = handle->files;
+        handle->files = *list;
+    }
+    *list = NULL;
+}
+
+static ARG_ARGUMENT_HANDLE convert_raw(ARG_DATA_HANDLE handle, ARG_ARGUMENT_HANDLE arg)
+{
+    if (arg == NULL || arg->raw == NULL)
+        return arg;
+
+    const char* raw = arg->raw;
+    arg->raw = NULL;
+    if (parse_value(handle, arg, &arg->value, raw) != ERROR_AP_NONE)
     {
-        HARGPARSE_ARG_LINKED next = handle->arguments;
-        while (next->next)
+        // the value is left as it was, so is its source
+        arg->parsed = arg->raw_parsed;
+        output_t* out = (handle->flags & ARGSPARSE_FLAG_QUIET) ? NULL : &handle->output;
+        if (out && output_stream(out, ARGSPARSE_STREAM_ERR))
         {
-            next = next->next;
+            output_format(out, "invalid value '%s' for option '--%s'\n", raw, arg->name);
+            output_flush(out);
         }
-        next->next = new_link;
+    }
+    return arg;
+}
+
+static int added_id(ARG_DATA_HANDLE handle, ARG_ERROR error)
+{
+    // put_argument appends
+    return error == ERROR_AP_NONE ? handle->count - 1 : error;
+}
+
+static ARG_ARGUMENT_HANDLE argument_at(ARG_DATA_HANDLE handle, int id)
+{
+    if (handle == NULL || id < 0 || id >= handle->count)
+        return NULL;
+
+    ARG_ARGUMENT_HANDLE arg = handle->arguments[id];
+    return arg->raw ? convert_raw(handle, arg) : arg;
+}
+
+static void convert_all_raw(ARG_DATA_HANDLE handle)
+{
+    for (int i = 0; i < handle->count; i++)
+    {
+        convert_raw(handle, handle->arguments[i]);
+    }
+}
+
+static ARG_ERROR create_cached(const char* title, const char* path, uint64_t key, argsparse_build_fn build, void* context, ARG_DATA_HANDLE* out)
+{
+    if (path == NULL || build == NULL)
+        return ERROR_AP_HANDLE;
+
+    ARG_DATA_HANDLE handle = NULL;
+    size_t size = 0;
+    file_map_t* map = file_map_open(path);
+    const void* image = map ? cache_image(map, key, &size) : NULL;
+    if (image)
+        handle = argsparse_ctx_deserialize(image, size);
+
+    ARG_ERROR error = ERROR_AP_NONE;
+    if (handle)
+    {
+        // the handle keeps the mapping its strings point into
+        map->next = handle->files;
+        handle->files = map;
+        handle->title = title;
     }
     else
-        handle->arguments = new_link;
+    {
+        // missing, stale or damaged
+        file_map_close(map);
+        handle = argsparse_ctx_create(title);
+        if (handle == NULL)
+            return ERROR_AP_MEMORY;
+
+        error = build(handle, context);
+        // best effort, a cache that cannot be written costs the next start only
+        if (error == ERROR_AP_NONE)
+            cache_write(handle, path, key);
+    }
 
+    if (error == ERROR_AP_NONE)
+        error = argsparse_ctx_freeze(handle);
+    if (error != ERROR_AP_NONE)
+    {
+        argsparse_ctx_free(handle);
+        return error;
+    }
+    *out = handle;
     return ERROR_AP_NONE;
 }
 
-static HARGPARSE_ARG_LINKED free_linked_argument(HARGPARSE_ARG_LINKED linked)
+static ARG_ERROR restore_arguments(ARG_DATA_HANDLE handle, const void* image, const image_header_t* header)
 {
-    HARGPARSE_ARG_LINKED next = NULL;
-    if (linked != NULL)
+    handle->flags = (int)header->flags;
+    handle->env_prefix = image_string(image, header->env_prefix);
+    for (uint32_t i = 0; i < header->count; i++)
     {
-        next = linked->next;
-        linked->next = NULL;
-        ARG_ARGUMENT_HANDLE* arg = &(linked->argument);
-        free_argument(arg);
-        free(linked);
+        image_entry_t entry;
+        image_entry(image, (int)i, &entry);
+        ARG_ARGUMENT_HANDLE arg = arena_alloc(&handle->arena, sizeof(argsparse_argument_t));
+        if (arg == NULL)
+            return ERROR_AP_MEMORY;
+
+        arg->type = (ARG_TYPE)entry.type;
+        arg->parsed = entry.parsed;
+        arg->name_short = entry.name_short;
+        arg->name = image_string(image, entry.name);
+        arg->description = image_string(image, entry.description);
+        arg->env = image_string(image, entry.env);
+        switch (arg->type)
+        {
+            case ARGSPARSE_TYPE_STRING:
+                arg->value.stringvalue = image_string(image, entry.string);
+                break;
+            case ARGSPARSE_TYPE_INT:
+                arg->value.intvalue = (int)entry.integer;
+                break;
+            case ARGSPARSE_TYPE_DOUBLE:
+                arg->value.doublevalue = entry.real;
+                break;
+            case ARGSPARSE_TYPE_FLAG:
+                arg->flagstorage = (int)entry.integer;
+                arg->value.flagptr = &arg->flagstorage;
+                arg->flag_init.flagvalue = entry.flagvalue;
+                break;
+            default:
+                break;
+        }
+
+        // also rejects duplicate names of a forged image
+        ARG_ERROR error = put_argument(handle, &arg);
+        if (error != ERROR_AP_NONE)
+            return error;
     }
-    return next;
+    return ERROR_AP_NONE;
 }
 
-/// @brief free argument and null
-/// @param handle null-safe
-static void free_argument(ARG_ARGUMENT_HANDLE* handle)
+/// @brief give rejected argument back to the arena and null
+/// @param href null-safe
+static void free_argument(ARG_DATA_HANDLE handle, ARG_ARGUMENT_HANDLE* href)
 {
-    if (*handle)
+    if (*href)
     {
-        free(*handle);
-        *handle = NULL;
+        arena_rollback(&handle->arena, *href);
+        *href = NULL;
     }
 }
 
@@ -385,33 +1573,19 @@ static void free_argument(ARG_ARGUMENT_HANDLE* handle)
 static ARG_ARGUMENT_HANDLE iterate_arguments_return_on_zero(ARG_DATA_HANDLE handle, int(*predicate)(int, ARG_ARGUMENT_HANDLE, void*), void* data)
 {
     ARG_ARGUMENT_HANDLE ret = NULL;
-    HARGPARSE_ARG_LINKED iterator = ((argument_data_t*)handle)->arguments;
-    int idx = 0;
-    while (iterator && predicate)
+    for (int idx = 0; predicate && idx < handle->count; idx++)
     {
-        ARG_ARGUMENT_HANDLE argument = iterator->argument;
+        ARG_ARGUMENT_HANDLE argument = handle->arguments[idx];
         // call predicate and return when zero
         if ((*predicate)(idx, argument, data) == 0)
         {
             ret = argument;
             break;
         }
-        idx++;
-        iterator = iterator->next;
     }
     return ret;
 }
 
-static int action_do_option_long(int idx, ARG_ARGUMENT_HANDLE arg, void* data)
-{
-    struct option* options = (struct option*)data;
-    options[idx].name = arg->name;
-    options[idx].has_arg = arg->type != ARGSPARSE_TYPE_NONE && arg->type != ARGSPARSE_TYPE_FLAG;
-    options[idx].val = (arg->type == ARGSPARSE_TYPE_FLAG) ? arg->flag_init.flagvalue : arg->name_short;
-    options[idx].flag = (arg->type == ARGSPARSE_TYPE_FLAG) ? arg->value.flagptr : NULL;
-    return 1;
-}
-
 static int action_long_option_width(int idx, ARG_ARGUMENT_HANDLE arg, void* data)
 {
     size_t width = strlen(arg->name);
@@ -422,71 +1596,38 @@ static int action_long_option_width(int idx, ARG_ARGUMENT_HANDLE arg, void* data
 
 static int action_show_argument_usage(int idx, ARG_ARGUMENT_HANDLE arg, void* data)
 {
-    char buffer[ARGSPARSE_MAX_STRING_SIZE] = {0,};
-    printf("-%c, ", arg->name_short);
-    printf("--%s\n", arg->name);
-    printf("    desc: %s\n", arg->description);
+    char buffer[VALUE_STRING_SIZE] = {0,};
+    output_t* out = ((show_data_t*)data)->out;
+    output_format(out, "-%c, --%s\n", arg->name_short, arg->name);
+    output_format(out, "    desc: %s\n", arg->description);
     if (arg->type != ARGSPARSE_TYPE_NONE)
     {
-        printf("    args: [%s", get_argument_type_string(arg->type));
-        printf(":%s", get_argument_value_string(arg, buffer, ARGSPARSE_MAX_STRING_SIZE));
-        printf("]\n");
+        output_format(out, "    args: [%s:%s]\n", get_argument_type_string(arg->type),
+            get_argument_value_string(arg, buffer, sizeof(buffer)));
     }
-    printf("\n");
+    output_cstr(out, "\n");
     return 1;
 }
 
 static int action_show_argument_value(int idx, ARG_ARGUMENT_HANDLE arg, void* data)
 {
-    char buffer[ARGSPARSE_MAX_STRING_SIZE] = {0,};
+    char buffer[VALUE_STRING_SIZE] = {0,};
     if (arg->type != ARGSPARSE_TYPE_NONE)
     {
-        size_t width = (uintptr_t)(data);
+        output_t* out = ((show_data_t*)data)->out;
+        size_t width = ((show_data_t*)data)->width;
         if (width != 0 && width < 20)
         {
-            printf("    %*s: ", (int)width, arg->name);
+            output_format(out, "    %*s: ", (int)width, arg->name);
         }
         else
         {
-            printf("    %s: ", arg->name);
+            output_format(out, "    %s: ", arg->name);
         }
 
-        printf("[%s]", get_argument_type_string(arg->type));
-        printf(" %s", get_argument_value_string(arg, buffer, ARGSPARSE_MAX_STRING_SIZE));
-        printf("\n");
-    }
-    return 1;
-}
-
-static int action_count(int idx, ARG_ARGUMENT_HANDLE arg, void* data)
-{
-    int* p = (int*)(uintptr_t)data;
-    int value = *p;
-    *p = value + 1;
-    return 1;
-}
-
-static int action_mark_parsed_flags(int idx, ARG_ARGUMENT_HANDLE arg, void* data)
-{
-    if (arg && arg->type == ARGSPARSE_TYPE_FLAG)
-    {
-        // flag value was set by getopts_long
-        if (*arg->value.flagptr == arg->flag_init.flagvalue)
-        {
-            arg->parsed = 1;
-        }
+        output_format(out, "[%s] %s\n", get_argument_type_string(arg->type),
+            get_argument_value_string(arg, buffer, sizeof(buffer)));
     }
     return 1;
 }
 
-static int predicate_compare_name(int idx, ARG_ARGUMENT_HANDLE arg, void* data)
-{
-    const char* name = (const char*)data;
-    return strcmp(name, arg->name);
-}
-
-static int predicate_compare_short_name(int idx, ARG_ARGUMENT_HANDLE arg, void* data)
-{
-    int name = *((int*)data);
-    return (name == arg->name_short) ? 0 : 1;
-}
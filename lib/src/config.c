@@ -0,0 +1,68 @@
+#include "config.h"
+
+#include <string.h>
+
+static int is_blank(char c)
+{
+    return c == ' ' || c == '\t' || c == '\r' || c == '\v' || c == '\f';
+}
+
+void config_init(config_reader_t* reader, char* text, size_t length)
+{
+    reader->next = text;
+    reader->end = text + length;
+    reader->line = 0;
+}
+
+int config_next(config_reader_t* reader, config_entry_t* entry)
+{
+    while (reader->next < reader->end)
+    {
+        char* line = reader->next;
+        char* newline = memchr(line, '\n', (size_t)(reader->end - line));
+        char* end = newline ? newline : reader->end;
+        reader->next = newline ? newline + 1 : reader->end;
+        reader->line++;
+
+        while (line < end && is_blank(*line))
+        {
+            line++;
+        }
+        while (end > line && is_blank(end[-1]))
+        {
+            end--;
+        }
+        if (line == end || *line == '#' || *line == ';' || *line == '[')
+            continue;
+
+        char* equals = memchr(line, '=', (size_t)(end - line));
+        char* key_end = equals ? equals : end;
+        while (key_end > line && is_blank(key_end[-1]))
+        {
+            key_end--;
+        }
+
+        entry->key = line;
+        entry->key_length = (size_t)(key_end - line);
+        entry->line = reader->line;
+        entry->value = NULL;
+        if (equals)
+        {
+            char* value = equals + 1;
+            while (value < end && is_blank(*value))
+            {
+                value++;
+            }
+            if (end - value >= 2 && (*value == '"' || *value == '\'') && end[-1] == *value)
+            {
+                value++;
+                end--;
+            }
+            // the newline, trailing blank or closing quote, or text[length]
+            *end = '\0';
+            entry->value = value;
+        }
+        return 1;
+    }
+    return 0;
+}
@@ -0,0 +1,182 @@
+#include "file_map.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+
+#if !defined(_WIN32)
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#else
+#include <io.h>
+#endif
+
+#define FILE_READ_CHUNK 65536
+
+/// @brief read fallback, also for pipes and sizes mmap has no spare byte for
+static char* read_all(FILE* file, size_t* size)
+{
+    size_t capacity = *size + 1 > FILE_READ_CHUNK ? *size + 1 : FILE_READ_CHUNK;
+    size_t length = 0;
+    char* data = malloc(capacity);
+    while (data)
+    {
+        length += fread(data + length, 1, capacity - length, file);
+        if (length < capacity)
+            break;
+
+        char* grown = realloc(data, capacity * 2);
+        if (grown == NULL)
+        {
+            free(data);
+            return NULL;
+        }
+        data = grown;
+        capacity *= 2;
+    }
+
+    if (data == NULL || ferror(file))
+    {
+        free(data);
+        return NULL;
+    }
+    data[length] = '\0';
+    *size = length;
+    return data;
+}
+
+/// @brief read what is left of file into map, closes file
+static file_map_t* read_into(file_map_t* map, FILE* file)
+{
+    if (file)
+    {
+        map->data = read_all(file, &map->size);
+        fclose(file);
+    }
+    if (map->data == NULL)
+    {
+        free(map);
+        return NULL;
+    }
+    return map;
+}
+
+#if !defined(_WIN32)
+/// @brief map fd when the last page has a spare byte for the terminator
+/// @return 1 when mapped, 0 when the caller has to read instead
+static int map_descriptor(file_map_t* map, int fd, int* regular)
+{
+    struct stat info;
+    long page = sysconf(_SC_PAGESIZE);
+    *regular = fstat(fd, &info) == 0 && S_ISREG(info.st_mode);
+    // read size hint
+    map->size = *regular ? (size_t)info.st_size : 0;
+    if (*regular && info.st_size > 0 && page > 0 && info.st_size % page != 0)
+    {
+        // the zero filled tail of the last page holds the terminator
+        void* data = mmap(NULL, map->size + 1, PROT_READ | PROT_WRITE, MAP_PRIVATE, fd, 0);
+        if (data != MAP_FAILED)
+        {
+            madvise(data, map->size + 1, MADV_SEQUENTIAL);
+            map->data = data;
+            map->mapped = map->size + 1;
+            return 1;
+        }
+    }
+    return 0;
+}
+#endif
+
+file_map_t* file_map_open(const char* path)
+{
+    file_map_t* map = calloc(1, sizeof(file_map_t));
+    if (map == NULL)
+        return NULL;
+
+#if !defined(_WIN32)
+    int fd = open(path, O_RDONLY);
+    if (fd < 0)
+    {
+        free(map);
+        return NULL;
+    }
+
+    int regular;
+    if (map_descriptor(map, fd, &regular))
+    {
+        close(fd);
+        return map;
+    }
+
+    FILE* file = fdopen(fd, "rb");
+    if (file == NULL)
+        close(fd);
+#else
+    FILE* file = fopen(path, "rb");
+#endif
+    return read_into(map, file);
+}
+
+file_map_t* file_map_open_fd(int fd)
+{
+    file_map_t* map = calloc(1, sizeof(file_map_t));
+    if (map == NULL)
+        return NULL;
+
+#if !defined(_WIN32)
+    int regular;
+    if (map_descriptor(map, fd, &regular))
+        return map;
+
+    // read through a duplicate so the caller keeps its descriptor
+    int copy = dup(fd);
+    if (copy >= 0 && regular)
+        lseek(copy, 0, SEEK_SET);
+    FILE* file = copy >= 0 ? fdopen(copy, "rb") : NULL;
+    if (file == NULL && copy >= 0)
+        close(copy);
+#else
+    int copy = _dup(fd);
+    if (copy >= 0)
+        _lseeki64(copy, 0, SEEK_SET);
+    FILE* file = copy >= 0 ? _fdopen(copy, "rb") : NULL;
+    if (file == NULL && copy >= 0)
+        _close(copy);
+#endif
+    return read_into(map, file);
+}
+
+void file_map_close(file_map_t* map)
+{
+    if (map == NULL)
+        return;
+
+#if !defined(_WIN32)
+    if (map->mapped)
+        munmap(map->data, map->mapped);
+    else
+#endif
+        free(map->data);
+    free(map);
+}
+
+void file_map_close_all(file_map_t* list)
+{
+    while (list)
+    {
+        file_map_t* next = list->next;
+        file_map_close(list);
+        list = next;
+    }
+}
+
+int file_map_contains(const file_map_t* list, const char* p)
+{
+    for (; list && p; list = list->next)
+    {
+        if (p >= list->data && p <= list->data + list->size)
+            return 1;
+    }
+    return 0;
+}
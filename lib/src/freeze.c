@@ -0,0 +1,267 @@
+#include "freeze.h"
+#include "internal_funcs.h"
+#include "internal_types.h"
+#include "parser.h"
+
+#include <stdlib.h>
+#include <string.h>
+
+static size_t align_up(size_t size)
+{
+    const size_t alignment = sizeof(void*) > sizeof(double) ? sizeof(void*) : sizeof(double);
+    return (size + alignment - 1) & ~(alignment - 1);
+}
+
+static int compare_names(const void* a, const void* b)
+{
+    return strcmp((*(const frozen_option_t* const*)a)->name, (*(const frozen_option_t* const*)b)->name);
+}
+
+/// @brief Sort the names and build the trie breadth first, so that the
+/// children of a node are appended next to each other
+static int build_trie(frozen_schema_t* schema)
+{
+    int count = schema->count;
+    const frozen_option_t** order = malloc((count ? count : 1) * sizeof(frozen_option_t*));
+    if (order == NULL)
+        return 0;
+
+    for (int i = 0; i < count; i++)
+    {
+        order[i] = &schema->options[i];
+    }
+    qsort(order, count, sizeof(order[0]), compare_names);
+    for (int i = 0; i < count; i++)
+    {
+        schema->sorted[i] = (int32_t)(order[i] - schema->options);
+    }
+    free(order);
+
+    frozen_node_t* root = &schema->nodes[0];
+    memset(root, 0, sizeof(*root));
+    root->exact = -1;
+    root->hi = (uint32_t)count;
+    schema->node_bytes[0] = 0;
+    schema->node_count = 1;
+
+    for (uint32_t n = 0; n < schema->node_count; n++)
+    {
+        frozen_node_t* node = &schema->nodes[n];
+        uint32_t depth = node->depth;
+        uint32_t lo = node->lo;
+        // a name ending here sorts before the longer ones
+        if (lo < node->hi && schema->options[schema->sorted[lo]].length == depth)
+        {
+            node->exact = schema->sorted[lo];
+            lo++;
+        }
+
+        node->first_child = schema->node_count;
+        while (lo < node->hi)
+        {
+            const char* first = schema->options[schema->sorted[lo]].name;
+            uint32_t hi = lo + 1;
+            while (hi < node->hi && schema->options[schema->sorted[hi]].name[depth] == first[depth])
+            {
+                hi++;
+            }
+
+            // sorted, so the first and last names bound the common prefix
+            const char* last = schema->options[schema->sorted[hi - 1]].name;
+            uint32_t end = depth + 1;
+            while (first[end] != '\0' && first[end] == last[end])
+            {
+                end++;
+            }
+
+            frozen_node_t* child = &schema->nodes[schema->node_count];
+            child->label = first + depth;
+            child->label_length = end - depth;
+            child->depth = end;
+            child->exact = -1;
+            child->lo = lo;
+            child->hi = hi;
+            child->first_child = 0;
+            child->child_count = 0;
+            schema->node_bytes[schema->node_count] = (unsigned char)first[depth];
+            schema->node_count++;
+            lo = hi;
+        }
+        node->child_count = schema->node_count - node->first_child;
+    }
+    return 1;
+}
+
+frozen_schema_t* frozen_schema_create(ARG_DATA_HANDLE handle)
+{
+    int count = handle->count;
+    size_t capacity = 16;
+    // keep the name table at most half full
+    while (capacity < (size_t)count * 2)
+    {
+        capacity *= 2;
+    }
+
+    size_t options_offset = align_up(sizeof(frozen_schema_t));
+    size_t slots_offset = options_offset + align_up(count * sizeof(frozen_option_t));
+    size_t defaults_offset = slots_offset + align_up(capacity * sizeof(frozen_slot_t));
+    size_t sorted_offset = defaults_offset + align_up(count * sizeof(ARG_VALUE));
+    // a node per name and at most one branching node per name besides
+    size_t max_nodes = 2 * (size_t)count + 1;
+    size_t nodes_offset = sorted_offset + align_up(count * sizeof(int32_t));
+    size_t bytes_offset = nodes_offset + max_nodes * sizeof(frozen_node_t);
+    size_t total = bytes_offset + max_nodes;
+
+    char* block = malloc(total);
+    if (block == NULL)
+    {
+        return NULL;
+    }
+
+    frozen_schema_t* schema = (frozen_schema_t*)block;
+    schema->count = count;
+    schema->slot_mask = (uint32_t)(capacity - 1);
+    schema->options = (frozen_option_t*)(block + options_offset);
+    schema->slots = (frozen_slot_t*)(block + slots_offset);
+    schema->defaults = (ARG_VALUE*)(block + defaults_offset);
+    schema->sorted = (int32_t*)(block + sorted_offset);
+    schema->nodes = (frozen_node_t*)(block + nodes_offset);
+    schema->node_bytes = (unsigned char*)(block + bytes_offset);
+
+    for (int i = 0; i < 256; i++)
+    {
+        schema->short_map[i] = -1;
+    }
+    for (size_t i = 0; i < capacity; i++)
+    {
+        schema->slots[i].hash = 0;
+        schema->slots[i].option = -1;
+    }
+
+    for (int idx = 0; idx < count; idx++)
+    {
+        ARG_ARGUMENT_HANDLE arg = handle->arguments[idx];
+        frozen_option_t* option = &schema->options[idx];
+        option->argument = arg;
+        option->name = arg->name;
+        option->length = (uint32_t)strlen(arg->name);
+        option->hash = name_hash(arg->name, option->length);
+        option->takes_value = parser_takes_value(arg);
+
+        uint32_t slot = option->hash & schema->slot_mask;
+        while (schema->slots[slot].option >= 0)
+        {
+            slot = (slot + 1) & schema->slot_mask;
+        }
+        schema->slots[slot].hash = option->hash;
+        schema->slots[slot].option = idx;
+
+        if (arg->name_short > 0 && arg->name_short < 256)
+        {
+            schema->short_map[arg->name_short] = idx;
+        }
+
+        memcpy(&schema->defaults[idx], &arg->value, sizeof(ARG_VALUE));
+        if (arg->type == ARGSPARSE_TYPE_FLAG)
+        {
+            schema->defaults[idx].intvalue = *arg->value.flagptr;
+        }
+        else if (arg->type == ARGSPARSE_TYPE_STRING && arg->copy && arg->value.stringvalue == arg->copy)
+        {
+            // the copy is reused by the next parse, the default has to stay
+            const char* pooled = intern_string(handle, arg->copy);
+            if (pooled == NULL)
+            {
+                free(block);
+                return NULL;
+            }
+            schema->defaults[idx].stringvalue = pooled;
+        }
+    }
+
+    if (!build_trie(schema))
+    {
+        free(block);
+        return NULL;
+    }
+    return schema;
+}
+
+ARG_ARGUMENT_HANDLE frozen_find_name(const frozen_schema_t* schema, const char* name, size_t length)
+{
+    uint32_t hash = name_hash(name, length);
+    uint32_t slot = hash & schema->slot_mask;
+    while (schema->slots[slot].option >= 0)
+    {
+        const frozen_option_t* option = &schema->options[schema->slots[slot].option];
+        if (schema->slots[slot].hash == hash && option->length == length && memcmp(option->name, name, length) == 0)
+        {
+            return option->argument;
+        }
+        slot = (slot + 1) & schema->slot_mask;
+    }
+    return NULL;
+}
+
+ARG_ARGUMENT_HANDLE frozen_find_prefix(const frozen_schema_t* schema, const char* name, size_t length, int* ambiguous)
+{
+    *ambiguous = 0;
+    // full names, the common case, hash faster than walking the trie
+    ARG_ARGUMENT_HANDLE found = frozen_find_name(schema, name, length);
+    if (found || length == 0)
+        return found;
+
+    const frozen_node_t* node = schema->nodes;
+    size_t position = 0;
+    int inside_label = 0;
+    while (position < length)
+    {
+        const unsigned char* bytes = schema->node_bytes + node->first_child;
+        const unsigned char* hit = memchr(bytes, (unsigned char)name[position], node->child_count);
+        if (hit == NULL)
+            return NULL;
+
+        node = &schema->nodes[node->first_child + (hit - bytes)];
+        size_t remaining = length - position;
+        size_t compared = node->label_length < remaining ? node->label_length : remaining;
+        if (memcmp(node->label + 1, name + position + 1, compared - 1) != 0)
+            return NULL;
+
+        position += compared;
+        inside_label = compared < node->label_length;
+    }
+
+    if (!inside_label && node->exact >= 0)
+        return schema->options[node->exact].argument;
+
+    uint32_t candidates = node->hi - node->lo;
+    if (candidates == 1)
+        return schema->options[schema->sorted[node->lo]].argument;
+
+    *ambiguous = (int)candidates;
+    return NULL;
+}
+
+ARG_ARGUMENT_HANDLE frozen_find_short(const frozen_schema_t* schema, int c)
+{
+    int32_t idx = (c > 0 && c < 256) ? schema->short_map[c] : -1;
+    return idx >= 0 ? schema->options[idx].argument : NULL;
+}
+
+void frozen_reset(const frozen_schema_t* schema)
+{
+    for (int i = 0; i < schema->count; i++)
+    {
+        ARG_ARGUMENT_HANDLE arg = schema->options[i].argument;
+        if (arg->type == ARGSPARSE_TYPE_FLAG)
+        {
+            *arg->value.flagptr = schema->defaults[i].intvalue;
+        }
+        else
+        {
+            memcpy(&arg->value, &schema->defaults[i], sizeof(ARG_VALUE));
+        }
+        arg->parsed = 0;
+        arg->raw = NULL;
+    }
+}
@@ -1,11 +1,29 @@
 
+#if !defined(_MSC_VER) && !defined(_GNU_SOURCE)
+// strtod_l, newlocale
+#   define _GNU_SOURCE
+#endif
+
 #include "internal_funcs.h"
+#include "scan.h"
 
+#include <errno.h>
+#include <float.h>
+#include <limits.h>
+#include <locale.h>
+#include <math.h>
 #include <stdlib.h>
 #include <stdio.h>
 #include <malloc.h>
+#include <stdint.h>
 #include <string.h>
 
+#if defined(_MSC_VER)
+#   include <windows.h>
+#elif defined(__APPLE__)
+#   include <xlocale.h>
+#endif
+
 const char* get_argument_type_string(ARG_TYPE type)
 {
     switch (type)
@@ -42,38 +60,314 @@ const char* get_argument_value_string(ARG_ARGUMENT_HANDLE arg, char* buffer, siz
             snprintf(buffer, buflen, "%f", arg->value.doublevalue);
             break;
         case ARGSPARSE_TYPE_STRING:
-            snprintf(buffer, buflen, "%s", arg->value.stringvalue);
+            // no copy, strings have no length limit
+            return arg->value.stringvalue;
         default:
             break;
     }
     return buffer;
 }
 
-void copy_to_argument_string(char* dest, const char* source)
+const char* intern_string(ARG_DATA_HANDLE handle, const char* source)
+{
+    if (source == NULL)
+        source = "";
+
+    return string_pool_intern(&handle->strings, source, strlen(source));
+}
+
+const char* copy_value(ARG_ARGUMENT_HANDLE arg, const char* value, size_t length)
 {
-    size_t len = strlen(source);
-    len = len < ARGSPARSE_MAX_STRING_SIZE ? len : ARGSPARSE_MAX_STRING_SIZE - 1;
-    strncpy(dest, source, len);
-    dest[len] = '\0';
+    if (length >= arg->copy_size)
+    {
+        // at least double so that growing values copy in amortized time
+        size_t size = arg->copy_size * 2 > length + 1 ? arg->copy_size * 2 : length + 1;
+        char* copy = realloc(arg->copy, size);
+        if (copy == NULL)
+            return NULL;
+
+        arg->copy = copy;
+        arg->copy_size = size;
+    }
+    // the value may already be the copy
+    memmove(arg->copy, value, length);
+    arg->copy[length] = '\0';
+    return arg->copy;
 }
 
 const char* find_string_end(const char* str)
 {
-    char terminators[] = {'\0'};
-    const char* end = NULL;
-    if (str != NULL)
+    return str ? str + scan_length(str) : NULL;
+}
+
+/////////////////////
+// Numeric parsing //
+/////////////////////
+
+int parse_int(const char* str, const char* end, int* out)
+{
+    const char* p = str;
+    int negative = 0;
+    if (p < end && (*p == '-' || *p == '+'))
+    {
+        negative = *p == '-';
+        p++;
+    }
+    if (p == end)
+        return ERROR_AP_FORMAT;
+
+    uint64_t value = 0;
+    int overflow = 0;
+    for (; p < end; p++)
     {
-        for (int i = 0; str && end == NULL && i < sizeof(terminators); i++)
+        unsigned digit = (unsigned)(unsigned char)*p - '0';
+        if (digit > 9)
+            return ERROR_AP_FORMAT;
+
+        value = value * 10 + digit;
+        // sticky, value may wrap after this
+        overflow |= value > (uint64_t)INT_MAX + 1;
+    }
+
+    if (overflow || value > (uint64_t)INT_MAX + (uint64_t)negative)
+        return ERROR_AP_RANGE;
+
+    *out = negative ? (int)(-(int64_t)value) : (int)value;
+    return ERROR_AP_NONE;
+}
+
+#if defined(_MSC_VER)
+typedef _locale_t c_locale_t;
+#   define create_c_locale() _create_locale(LC_NUMERIC, "C")
+#   define free_c_locale(loc) _free_locale(loc)
+#   define strtod_c(str, endptr, loc) _strtod_l(str, endptr, loc)
+#   define cas_locale(target, expected, desired) \
+        (InterlockedCompareExchangePointer((void* volatile*)(target), desired, expected) == (expected))
+#else
+typedef locale_t c_locale_t;
+#   define create_c_locale() newlocale(LC_NUMERIC_MASK, "C", (locale_t)0)
+#   define free_c_locale(loc) freelocale(loc)
+#   define strtod_c(str, endptr, loc) strtod_l(str, endptr, loc)
+#   define cas_locale(target, expected, desired) \
+        __atomic_compare_exchange_n(target, &(expected), desired, 0, __ATOMIC_ACQ_REL, __ATOMIC_ACQUIRE)
+#endif
+
+/// @brief "C" numeric locale created once, independent of setlocale()
+/// @return locale or 0 when it cannot be created, retried on the next call
+static c_locale_t get_c_locale()
+{
+    static c_locale_t s_locale = (c_locale_t)0;
+#if defined(_MSC_VER)
+    c_locale_t loc = s_locale;
+#else
+    c_locale_t loc = __atomic_load_n(&s_locale, __ATOMIC_ACQUIRE);
+#endif
+    if (loc == (c_locale_t)0)
+    {
+        c_locale_t created = create_c_locale();
+        if (created == (c_locale_t)0)
+            return created;
+
+        c_locale_t expected = (c_locale_t)0;
+        if (cas_locale(&s_locale, expected, created))
         {
-            end = strchr(str, terminators[i]);
+            loc = created;
         }
+        else
+        {
+            // another thread won
+            free_c_locale(created);
+            loc = s_locale;
+        }
+    }
+    return loc;
+}
+
+/// @brief correctly rounded fallback for what the fast path can not do exactly
+static int parse_double_slow(const char* str, const char* end, double* out)
+{
+    // strtod_l with no locale is undefined
+    c_locale_t loc = get_c_locale();
+    if (loc == (c_locale_t)0)
+        return ERROR_AP_MEMORY;
+
+    char local[64];
+    size_t length = (size_t)(end - str);
+    char* copy = length < sizeof(local) ? local : malloc(length + 1);
+    if (copy == NULL)
+        return ERROR_AP_MEMORY;
+
+    memcpy(copy, str, length);
+    copy[length] = '\0';
+
+    char* stop = NULL;
+    errno = 0;
+    double value = strtod_c(copy, &stop, loc);
+    int ret = (stop != copy + length) ? ERROR_AP_FORMAT
+            : (errno == ERANGE && isinf(value)) ? ERROR_AP_RANGE
+            : ERROR_AP_NONE;
+    if (copy != local)
+        free(copy);
+
+    if (ret == ERROR_AP_NONE)
+        *out = value;
+    return ret;
+}
+
+static int match_word(const char* p, const char* end, const char* word)
+{
+    size_t length = strlen(word);
+    if ((size_t)(end - p) != length)
+        return 0;
+
+    for (size_t i = 0; i < length; i++)
+    {
+        if ((p[i] | 0x20) != word[i])
+            return 0;
     }
-    return end;
+    return 1;
 }
 
-int parse_value(ARG_VALUE* ref, ARG_TYPE type, const char* str_value)
+int parse_double(const char* str, const char* end, double* out)
+{
+    // powers of ten exactly representable as double
+    static const double exact_powers[] = {
+        1e0, 1e1, 1e2, 1e3, 1e4, 1e5, 1e6, 1e7, 1e8, 1e9, 1e10, 1e11,
+        1e12, 1e13, 1e14, 1e15, 1e16, 1e17, 1e18, 1e19, 1e20, 1e21, 1e22 };
+    const uint64_t exact_mantissa = (uint64_t)1 << 53;
+
+    const char* p = str;
+    int negative = 0;
+    if (p < end && (*p == '-' || *p == '+'))
+    {
+        negative = *p == '-';
+        p++;
+    }
+
+    if (match_word(p, end, "inf") || match_word(p, end, "infinity"))
+    {
+        *out = negative ? -HUGE_VAL : HUGE_VAL;
+        return ERROR_AP_NONE;
+    }
+    if (match_word(p, end, "nan"))
+    {
+        *out = negative ? -NAN : NAN;
+        return ERROR_AP_NONE;
+    }
+
+    // up to 19 significant digits fit in the mantissa
+    uint64_t mantissa = 0;
+    int digits = 0;
+    int exponent = 0;
+    int truncated = 0;
+    int seen = 0;
+    for (; p < end && (unsigned)(*p - '0') <= 9; p++, seen = 1)
+    {
+        unsigned digit = (unsigned)(*p - '0');
+        if (digits < 19)
+        {
+            mantissa = mantissa * 10 + digit;
+            digits += mantissa != 0;
+        }
+        else
+        {
+            exponent++;
+            truncated |= digit != 0;
+        }
+    }
+    if (p < end && *p == '.')
+    {
+        for (p++; p < end && (unsigned)(*p - '0') <= 9; p++, seen = 1)
+        {
+            unsigned digit = (unsigned)(*p - '0');
+            if (digits < 19)
+            {
+                mantissa = mantissa * 10 + digit;
+                digits += mantissa != 0;
+                exponent--;
+            }
+            else
+            {
+                truncated |= digit != 0;
+            }
+        }
+    }
+    if (!seen)
+        return ERROR_AP_FORMAT;
+
+    if (p < end && (*p == 'e' || *p == 'E'))
+    {
+        int exp_negative = 0;
+        int exp_value = 0;
+        p++;
+        if (p < end && (*p == '-' || *p == '+'))
+        {
+            exp_negative = *p == '-';
+            p++;
+        }
+        if (p == end)
+            return ERROR_AP_FORMAT;
+
+        for (; p < end && (unsigned)(*p - '0') <= 9; p++)
+        {
+            // far beyond any double, only keeps it from overflowing
+            if (exp_value < 100000)
+                exp_value = exp_value * 10 + (*p - '0');
+        }
+        exponent += exp_negative ? -exp_value : exp_value;
+    }
+    if (p != end)
+        return ERROR_AP_FORMAT;
+
+    if (mantissa == 0 && !truncated)
+    {
+        *out = negative ? -0.0 : 0.0;
+        return ERROR_AP_NONE;
+    }
+
+#if defined(FLT_EVAL_METHOD) && FLT_EVAL_METHOD == 0
+    // Clinger's fast path: both operands exact gives one correctly rounded operation
+    if (!truncated && mantissa <= exact_mantissa)
+    {
+        double value = (double)mantissa;
+        if (exponent > 22 && exponent <= 22 + 15)
+        {
+            // move the excess into the mantissa while it stays exact
+            uint64_t shifted = mantissa;
+            int shift = exponent - 22;
+            while (shift > 0 && shifted <= exact_mantissa / 10)
+            {
+                shifted *= 10;
+                shift--;
+            }
+            if (shift == 0)
+            {
+                value = (double)shifted;
+                exponent = 22;
+            }
+        }
+
+        if (exponent >= 0 && exponent <= 22)
+        {
+            value *= exact_powers[exponent];
+            *out = negative ? -value : value;
+            return ERROR_AP_NONE;
+        }
+        if (exponent < 0 && exponent >= -22)
+        {
+            value /= exact_powers[-exponent];
+            *out = negative ? -value : value;
+            return ERROR_AP_NONE;
+        }
+    }
+#endif
+    return parse_double_slow(str, end, out);
+}
+
+int parse_value(ARG_DATA_HANDLE handle, ARG_ARGUMENT_HANDLE arg, ARG_VALUE* ref, const char* str_value)
 {
     int ret = 0;
+    ARG_TYPE type = arg->type;
 
     if (type == ARGSPARSE_TYPE_NONE)
         return -1;
@@ -81,30 +375,48 @@ int parse_value(ARG_VALUE* ref, ARG_TYPE type, const char* str_value)
     switch (type)
     {
         case ARGSPARSE_TYPE_FLAG:
-            // getopt_long already set the option.val to option.flag
+            // the parse loop sets the flag
             break;
         case ARGSPARSE_TYPE_DOUBLE:
-            ref->doublevalue = str_value ? atof(str_value) : -1.0;
+        {
+            double value = 0.0;
+            ret = str_value ? parse_double(str_value, str_value + strlen(str_value), &value) : ERROR_AP_FORMAT;
+            if (ret == ERROR_AP_NONE)
+                ref->doublevalue = value;
+        }
         break;
         case ARGSPARSE_TYPE_INT:
-            ref->intvalue = str_value ? atoi(str_value) : -1;
+        {
+            int value = 0;
+            ret = str_value ? parse_int(str_value, str_value + strlen(str_value), &value) : ERROR_AP_FORMAT;
+            if (ret == ERROR_AP_NONE)
+                ref->intvalue = value;
+        }
         break;
         case ARGSPARSE_TYPE_STRING:
         {
+            if ((handle->flags & ARGSPARSE_FLAG_COPY_STRINGS) == 0)
+            {
+                // view into the caller buffer, no copy and no length limit
+                if (str_value && *str_value)
+                    ref->stringvalue = str_value;
+                else
+                    ret = ERROR_AP_FORMAT;
+                break;
+            }
+
             const char* end = find_string_end(str_value);
             if (end)
             {
                 ptrdiff_t len = end - str_value;
-                if (len > 0 && len < ARGSPARSE_MAX_STRING_SIZE)
-                {
-                    strncpy(ref->stringvalue, str_value, len);
-                    ref->stringvalue[len] = 0;
-                }
+                const char* copy = len > 0 ? copy_value(arg, str_value, (size_t)len) : NULL;
+                if (copy)
+                    ref->stringvalue = copy;
                 else
-                    ret = -1;
+                    ret = len > 0 ? ERROR_AP_MEMORY : ERROR_AP_FORMAT;
             }
             else
-                ret = -1;
+                ret = ERROR_AP_FORMAT;
         }
         break;
         default:
@@ -114,49 +426,61 @@ int parse_value(ARG_VALUE* ref, ARG_TYPE type, const char* str_value)
     return ret;
 }
 
+#define SHORT_USED(bits, c) ((bits)[(unsigned char)(c) >> 5] & (1u << ((unsigned char)(c) & 31)))
+
+// fallback characters 'a'..'z' without 'j' in the bitset word holding them
+#define SHORT_FALLBACK_WORD ('a' >> 5)
+#define SHORT_FALLBACK_MASK (((1u << 26) - 1) << ('a' & 31) & ~(1u << ('j' & 31)))
+
+static int lowest_set_bit(uint32_t bits)
+{
+#if defined(__GNUC__) || defined(__clang__)
+    return __builtin_ctz(bits);
+#else
+    int idx = 0;
+    while ((bits & 1u) == 0)
+    {
+        bits >>= 1;
+        idx++;
+    }
+    return idx;
+#endif
+}
+
 int set_short_option(char c, ARG_DATA_HANDLE handle, ARG_ARGUMENT_HANDLE arg)
 {
-    int ret = ERROR_AP_EXISTS;
-    char* opt = handle->shortopts;
-    // iterate used until terminating 0
-    while (*opt)
+    unsigned char uc = (unsigned char)c;
+    int takes_value = (arg->type != ARGSPARSE_TYPE_FLAG) && (arg->type != ARGSPARSE_TYPE_NONE);
+    int needed = takes_value ? 2 : 1;
+
+    if (uc == 0 || uc == ':' || SHORT_USED(handle->short_used, uc))
     {
-        if (*opt != ':' && *opt == c)
-        {
-            break;
-        }
-        opt++;
+        return ERROR_AP_EXISTS;
     }
-    // unused - set value and break
-    if (*opt == 0)
+
+    char* opt = handle->shortopts + handle->shortopts_length;
+    *opt++ = c;
+    if (takes_value)
     {
-        *opt = c;
-        if ((arg->type == ARGSPARSE_TYPE_FLAG) || (arg->type == ARGSPARSE_TYPE_NONE))
-        {
-            *(opt + 1) = '\0';
-        }
-        else
-        {
-            *(opt + 1) = ':';
-            *(opt + 2) = '\0';
-        }
-        arg->name_short = c;
-        ret = ERROR_AP_NONE;
+        *opt++ = ':';
     }
+    *opt = '\0';
+    handle->shortopts_length += needed;
 
-    return ret;
+    handle->short_used[uc >> 5] |= 1u << (uc & 31);
+    handle->short_map[uc] = arg;
+    arg->name_short = c;
+    return ERROR_AP_NONE;
 }
 
-char iterate_set_of_chars_for_short(const char* sopts, const char* charset)
+static char iterate_set_of_chars_for_short(const uint32_t* used, const char* charset)
 {
-    if (charset != NULL && sopts != NULL)
+    if (charset != NULL)
     {
-        size_t sopts_len = strlen(sopts);
         while (*charset)
         {
             char c = *charset;
-            char* used = sopts_len <= 0 ? NULL : strchr(sopts, c);
-            if (used == NULL)
+            if (c != ':' && !SHORT_USED(used, c))
             {
                 // found unused char
                 return c;
@@ -172,11 +496,14 @@ void generate_short_name(ARG_DATA_HANDLE handle, ARG_ARGUMENT_HANDLE arg)
     if (arg->type == ARGSPARSE_TYPE_FLAG)
         return;
 
-    char* longname = arg->name;
-    char shortopt = iterate_set_of_chars_for_short(handle->shortopts, longname);
+    char shortopt = iterate_set_of_chars_for_short(handle->short_used, arg->name);
     if (shortopt == '\0')
     {
-        shortopt = iterate_set_of_chars_for_short(handle->shortopts, "abcdefghiklmnopqrstuvwxyz");
+        uint32_t available = SHORT_FALLBACK_MASK & ~handle->short_used[SHORT_FALLBACK_WORD];
+        if (available == 0)
+            return;
+
+        shortopt = (char)((SHORT_FALLBACK_WORD << 5) + lowest_set_bit(available));
     }
 
     set_short_option(shortopt, handle, arg);
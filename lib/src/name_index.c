@@ -0,0 +1,98 @@
+#include "name_index.h"
+
+#include <stdlib.h>
+#include <string.h>
+
+#define NAME_INDEX_MIN_CAPACITY 16
+
+uint32_t name_hash(const char* key, size_t length)
+{
+    uint32_t hash = 2166136261u;
+    for (size_t i = 0; i < length; i++)
+    {
+        hash ^= (unsigned char)key[i];
+        hash *= 16777619u;
+    }
+    return hash;
+}
+
+static name_index_slot_t* find_slot(name_index_slot_t* slots, size_t capacity, const char* key, size_t length, uint32_t hash)
+{
+    size_t mask = capacity - 1;
+    size_t i = hash & mask;
+    while (slots[i].value != NULL)
+    {
+        if (slots[i].hash == hash && slots[i].length == length && memcmp(slots[i].key, key, length) == 0)
+        {
+            break;
+        }
+        i = (i + 1) & mask;
+    }
+    return &slots[i];
+}
+
+static ARG_ERROR grow(name_index_t* index)
+{
+    size_t capacity = index->capacity ? index->capacity * 2 : NAME_INDEX_MIN_CAPACITY;
+    name_index_slot_t* slots = calloc(capacity, sizeof(name_index_slot_t));
+    if (slots == NULL)
+    {
+        return ERROR_AP_MEMORY;
+    }
+
+    for (size_t i = 0; i < index->capacity; i++)
+    {
+        name_index_slot_t* old = &index->slots[i];
+        if (old->value)
+        {
+            *find_slot(slots, capacity, old->key, old->length, old->hash) = *old;
+        }
+    }
+    free(index->slots);
+    index->slots = slots;
+    index->capacity = capacity;
+    return ERROR_AP_NONE;
+}
+
+ARG_ERROR name_index_insert(name_index_t* index, const char* key, size_t length, uint32_t hash, void* value)
+{
+    // keep load factor below 3/4
+    if ((index->count + 1) * 4 > index->capacity * 3)
+    {
+        ARG_ERROR err = grow(index);
+        if (err)
+        {
+            return err;
+        }
+    }
+
+    name_index_slot_t* slot = find_slot(index->slots, index->capacity, key, length, hash);
+    if (slot->value)
+    {
+        return ERROR_AP_EXISTS;
+    }
+
+    slot->hash = hash;
+    slot->length = (uint32_t)length;
+    slot->key = key;
+    slot->value = value;
+    index->count++;
+    return ERROR_AP_NONE;
+}
+
+void* name_index_find(const name_index_t* index, const char* key, size_t length, uint32_t hash)
+{
+    if (index->capacity == 0)
+    {
+        return NULL;
+    }
+    return find_slot(index->slots, index->capacity, key, length, hash)->value;
+}
+
+void name_index_free(name_index_t* index)
+{
+    free(index->slots);
+    index->slots = NULL;
+    index->capacity = 0;
+    index->count = 0;
+}
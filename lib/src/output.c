@@ -0,0 +1,114 @@
+#include "output.h"
+
+#include <stdarg.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+void output_set_buffer(output_t* out, char* buffer, size_t size)
+{
+    output_flush(out);
+    out->buffer = (buffer && size) ? buffer : out->internal;
+    out->size = (buffer && size) ? size : (out->internal ? OUTPUT_BUFFER_SIZE : 0);
+}
+
+int output_stream(output_t* out, int stream)
+{
+    if (out->buffer == NULL)
+    {
+        out->internal = arena_alloc(out->arena, OUTPUT_BUFFER_SIZE);
+        out->buffer = out->internal;
+        out->size = out->buffer ? OUTPUT_BUFFER_SIZE : 0;
+        out->length = 0;
+    }
+    if (out->stream != stream)
+    {
+        output_flush(out);
+        out->stream = stream;
+    }
+    return out->buffer != NULL;
+}
+
+void output_text(output_t* out, const char* text, size_t length)
+{
+    if (out->buffer == NULL)
+        return;
+
+    while (length > 0)
+    {
+        if (out->length == out->size)
+            output_flush(out);
+
+        size_t chunk = out->size - out->length;
+        chunk = chunk < length ? chunk : length;
+        memcpy(out->buffer + out->length, text, chunk);
+        out->length += chunk;
+        text += chunk;
+        length -= chunk;
+    }
+}
+
+void output_cstr(output_t* out, const char* text)
+{
+    output_text(out, text, strlen(text));
+}
+
+void output_format(output_t* out, const char* format, ...)
+{
+    if (out->buffer == NULL)
+        return;
+
+    va_list args;
+    va_start(args, format);
+    size_t free_space = out->size - out->length;
+    int needed = vsnprintf(out->buffer + out->length, free_space, format, args);
+    va_end(args);
+    if (needed < 0)
+        return;
+
+    if ((size_t)needed < free_space)
+    {
+        out->length += (size_t)needed;
+        return;
+    }
+
+    // did not fit, format again after flushing or into a temporary
+    output_flush(out);
+    va_start(args, format);
+    if ((size_t)needed < out->size)
+    {
+        vsnprintf(out->buffer, out->size, format, args);
+        out->length = (size_t)needed;
+    }
+    else
+    {
+        char* text = malloc((size_t)needed + 1);
+        if (text)
+        {
+            vsnprintf(text, (size_t)needed + 1, format, args);
+            output_text(out, text, (size_t)needed);
+            free(text);
+        }
+    }
+    va_end(args);
+}
+
+void output_flush(output_t* out)
+{
+    if (out->length > 0)
+    {
+        if (out->write)
+            out->write(out->context, out->stream, out->buffer, out->length);
+        else
+            output_write_stdio(NULL, out->stream, out->buffer, out->length);
+        out->length = 0;
+    }
+}
+
+void output_write_stdio(void* context, int stream, const char* text, size_t length)
+{
+    (void)context;
+    FILE* file = stream == ARGSPARSE_STREAM_ERR ? stderr : stdout;
+    fwrite(text, 1, length, file);
+    fflush(file);
+}
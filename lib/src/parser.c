@@ -0,0 +1,198 @@
+#include "parser.h"
+#include "scan.h"
+
+#include <string.h>
+
+void parser_init(parser_cursor_t* cursor, char* const* argv, int argc)
+{
+    memset(cursor, 0, sizeof(*cursor));
+    cursor->argv = argv;
+    cursor->argc = argc;
+    cursor->index = 1;
+}
+
+void parser_finish(parser_cursor_t* cursor, file_map_t** owner)
+{
+    if (cursor->files)
+    {
+        file_map_t* last = cursor->files;
+        while (last->next)
+        {
+            last = last->next;
+        }
+        last->next = *owner;
+        *owner = cursor->files;
+        cursor->files = NULL;
+    }
+    cursor->depth = 0;
+}
+
+int parser_takes_value(ARG_ARGUMENT_HANDLE arg)
+{
+    return arg->type != ARGSPARSE_TYPE_NONE && arg->type != ARGSPARSE_TYPE_FLAG;
+}
+
+/// @brief Next argv or response file element with @files expanded
+/// @return element or NULL at the end, or on failure
+static const char* next_element(parser_cursor_t* cursor)
+{
+    for (;;)
+    {
+        const char* element = NULL;
+        while (cursor->depth > 0 && element == NULL)
+        {
+            element = tokenizer_next(&cursor->responses[cursor->depth - 1]);
+            if (element == NULL)
+                cursor->depth--;
+        }
+        if (element == NULL)
+        {
+            if (cursor->index >= cursor->argc)
+                return NULL;
+            element = cursor->argv[cursor->index++];
+        }
+
+        if (element[0] != '@' || element[1] == '\0')
+            return element;
+
+        if (cursor->depth == PARSER_MAX_RESPONSE_DEPTH)
+        {
+            cursor->token = element;
+            cursor->failure = PARSER_ERROR_RESPONSE_DEPTH;
+            return NULL;
+        }
+
+        file_map_t* file = file_map_open(element + 1);
+        if (file == NULL)
+            return element;
+
+        file->next = cursor->files;
+        cursor->files = file;
+        tokenizer_init(&cursor->responses[cursor->depth++], file->data, file->size);
+    }
+}
+
+/// @brief exact match first, then unique prefix like getopt_long
+static ARG_ARGUMENT_HANDLE find_long(ARG_DATA_HANDLE handle, const char* name, size_t length, int* ambiguous)
+{
+    if (handle->frozen)
+    {
+        return frozen_find_prefix(handle->frozen, name, length, ambiguous);
+    }
+
+    ARG_ARGUMENT_HANDLE found = name_index_find(&handle->names, name, length, name_hash(name, length));
+    *ambiguous = 0;
+    if (found == NULL && length > 0)
+    {
+        int candidates = 0;
+        for (int i = 0; i < handle->count; i++)
+        {
+            if (strncmp(handle->arguments[i]->name, name, length) == 0)
+            {
+                found = handle->arguments[i];
+                candidates++;
+            }
+        }
+        if (candidates > 1)
+        {
+            *ambiguous = candidates;
+            return NULL;
+        }
+    }
+    return found;
+}
+
+static parser_token_e next_long(ARG_DATA_HANDLE handle, parser_cursor_t* cursor, const char* name)
+{
+    // one pass for both the '=' and the end
+    size_t length = scan_name_end(name);
+    const char* equals = name[length] == '=' ? name + length : NULL;
+    int ambiguous = 0;
+
+    cursor->argument = find_long(handle, name, length, &ambiguous);
+    if (cursor->argument == NULL)
+    {
+        return ambiguous ? PARSER_ERROR_AMBIGUOUS : PARSER_ERROR_UNKNOWN;
+    }
+
+    if (!parser_takes_value(cursor->argument))
+    {
+        return equals ? PARSER_ERROR_UNEXPECTED_VALUE : PARSER_OPTION;
+    }
+
+    if (equals)
+    {
+        cursor->value = equals + 1;
+    }
+    else if ((cursor->value = next_element(cursor)) == NULL)
+    {
+        return cursor->failure ? cursor->failure : PARSER_ERROR_MISSING_VALUE;
+    }
+    return PARSER_OPTION;
+}
+
+static parser_token_e next_short(ARG_DATA_HANDLE handle, parser_cursor_t* cursor)
+{
+    unsigned char c = (unsigned char)*cursor->cluster++;
+    cursor->short_name = c;
+    cursor->argument = handle->frozen ? frozen_find_short(handle->frozen, c) : handle->short_map[c];
+    if (cursor->argument == NULL)
+    {
+        return PARSER_ERROR_UNKNOWN;
+    }
+
+    if (parser_takes_value(cursor->argument))
+    {
+        // "-xVALUE" or "-x VALUE"
+        if (*cursor->cluster)
+        {
+            cursor->value = cursor->cluster;
+        }
+        else if ((cursor->value = next_element(cursor)) == NULL)
+        {
+            cursor->cluster = NULL;
+            return cursor->failure ? cursor->failure : PARSER_ERROR_MISSING_VALUE;
+        }
+        cursor->cluster = NULL;
+    }
+    else if (*cursor->cluster == '\0')
+    {
+        cursor->cluster = NULL;
+    }
+    return PARSER_OPTION;
+}
+
+parser_token_e parser_next(ARG_DATA_HANDLE handle, parser_cursor_t* cursor)
+{
+    cursor->argument = NULL;
+    cursor->value = NULL;
+    cursor->short_name = 0;
+
+    if (cursor->cluster)
+    {
+        return next_short(handle, cursor);
+    }
+
+    const char* token;
+    while ((token = next_element(cursor)) != NULL)
+    {
+        cursor->token = token;
+
+        scan_class_e kind = cursor->operands_only ? SCAN_OPERAND : scan_classify(token);
+        switch (kind)
+        {
+            case SCAN_END_OF_OPTIONS:
+                cursor->operands_only = 1;
+                continue;
+            case SCAN_LONG:
+                return next_long(handle, cursor, token + 2);
+            case SCAN_SHORT:
+                cursor->cluster = token + 1;
+                return next_short(handle, cursor);
+            default:
+                cursor->value = token;
+                return PARSER_OPERAND;
+        }
+    }
+    return cursor->failure ? cursor->failure : PARSER_END;
+}
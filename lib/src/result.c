@@ -0,0 +1,100 @@
+#include "result.h"
+#include "internal_funcs.h"
+#include "parser.h"
+
+#include <stdlib.h>
+#include <string.h>
+
+argument_result_t* result_create(ARG_DATA_HANDLE handle)
+{
+    const frozen_schema_t* frozen = handle->frozen;
+    int count = frozen->count;
+    size_t values_offset = (sizeof(argument_result_t) + sizeof(ARG_VALUE) - 1) / sizeof(ARG_VALUE) * sizeof(ARG_VALUE);
+    size_t parsed_offset = values_offset + count * sizeof(ARG_VALUE);
+    size_t words = RESULT_PARSED_WORD(count + 31);
+
+    char* block = malloc(parsed_offset + words * sizeof(uint32_t));
+    if (block == NULL)
+        return NULL;
+
+    argument_result_t* result = (argument_result_t*)block;
+    result->schema = handle;
+    result->count = count;
+    result->values = (ARG_VALUE*)(block + values_offset);
+    result->parsed = (uint32_t*)(block + parsed_offset);
+    result->files = NULL;
+    result_reset(result);
+    return result;
+}
+
+void result_reset(argument_result_t* result)
+{
+    int count = result->count;
+    result->status = 0;
+    memcpy(result->values, result->schema->frozen->defaults, count * sizeof(ARG_VALUE));
+    memset(result->parsed, 0, RESULT_PARSED_WORD(count + 31) * sizeof(uint32_t));
+    file_map_close_all(result->files);
+    result->files = NULL;
+}
+
+int result_parse(ARG_DATA_HANDLE handle, argument_result_t* result, char* const* argv, int argc)
+{
+    int count = 0;
+    parser_cursor_t cursor;
+    parser_token_e token;
+    parser_init(&cursor, argv, argc);
+    while (count >= 0 && (token = parser_next(handle, &cursor)) != PARSER_END)
+    {
+        if (token == PARSER_OPERAND)
+            continue;
+
+        if (token != PARSER_OPTION)
+        {
+            count = ERROR_AP_UNKNOWN;
+            break;
+        }
+
+        ARG_ARGUMENT_HANDLE arg = cursor.argument;
+        ARG_VALUE* value = &result->values[arg->index];
+        int err = ERROR_AP_NONE;
+        switch (arg->type)
+        {
+            case ARGSPARSE_TYPE_FLAG:
+                value->intvalue = arg->flag_init.flagvalue;
+                break;
+            case ARGSPARSE_TYPE_STRING:
+                // always a view, the handle string pool is not shared
+                if (*cursor.value)
+                    value->stringvalue = cursor.value;
+                else
+                    err = ERROR_AP_FORMAT;
+                break;
+            case ARGSPARSE_TYPE_INT:
+            case ARGSPARSE_TYPE_DOUBLE:
+                err = parse_value(handle, arg, value, cursor.value);
+                break;
+            default:
+                break;
+        }
+
+        if (err)
+        {
+            count = err;
+            break;
+        }
+        result->parsed[RESULT_PARSED_WORD(arg->index)] |= RESULT_PARSED_BIT(arg->index);
+        count++;
+    }
+    parser_finish(&cursor, &result->files);
+    result->status = count;
+    return count;
+}
+
+void result_free(argument_result_t* result)
+{
+    if (result)
+    {
+        file_map_close_all(result->files);
+        free(result);
+    }
+}
@@ -0,0 +1,298 @@
+#include "scan.h"
+
+#include <stdint.h>
+
+#if defined(__x86_64__) || defined(_M_X64)
+#   define SCAN_X86 1
+#   include <immintrin.h>
+#   if defined(_MSC_VER)
+#       include <intrin.h>
+#   endif
+#else
+#   define SCAN_X86 0
+#endif
+
+#if defined(__GNUC__) || defined(__clang__)
+#   define SCAN_AVX2_TARGET __attribute__((target("avx2")))
+/// @brief aligned loads may read past the terminator, never past its page
+#   define SCAN_OVERREAD __attribute__((no_sanitize_address))
+#   define LOAD_LEVEL(p) __atomic_load_n((p), __ATOMIC_RELAXED)
+#   define STORE_LEVEL(p, v) __atomic_store_n((p), (v), __ATOMIC_RELAXED)
+#else
+#   define SCAN_AVX2_TARGET
+#   define SCAN_OVERREAD
+#   define LOAD_LEVEL(p) (*(volatile int*)(p))
+#   define STORE_LEVEL(p, v) (*(volatile int*)(p) = (v))
+#endif
+
+/// @brief resolved on first use, -1 before
+static int g_level = -1;
+
+static int lowest_bit(uint32_t bits)
+{
+#if defined(__GNUC__) || defined(__clang__)
+    return __builtin_ctz(bits);
+#elif defined(_MSC_VER)
+    unsigned long idx;
+    _BitScanForward(&idx, bits);
+    return (int)idx;
+#else
+    int idx = 0;
+    while ((bits & 1u) == 0)
+    {
+        bits >>= 1;
+        idx++;
+    }
+    return idx;
+#endif
+}
+
+static scan_level_e supported_level()
+{
+#if SCAN_X86 && defined(_MSC_VER)
+    int info[4];
+    __cpuid(info, 0);
+    if (info[0] < 7)
+        return SCAN_SSE2;
+
+    // the processor has AVX2 and the system saves the ymm registers
+    __cpuid(info, 1);
+    int osxsave = (info[2] & (1 << 27)) != 0;
+    __cpuidex(info, 7, 0);
+    if ((info[1] & (1 << 5)) && osxsave && (_xgetbv(0) & 6) == 6)
+        return SCAN_AVX2;
+    return SCAN_SSE2;
+#elif SCAN_X86
+    __builtin_cpu_init();
+    return __builtin_cpu_supports("avx2") ? SCAN_AVX2 : SCAN_SSE2;
+#else
+    return SCAN_SCALAR;
+#endif
+}
+
+scan_level_e scan_level()
+{
+    int level = LOAD_LEVEL(&g_level);
+    if (level < 0)
+    {
+        // racing threads detect the same level
+        level = supported_level();
+        STORE_LEVEL(&g_level, level);
+    }
+    return (scan_level_e)level;
+}
+
+scan_level_e scan_set_level(scan_level_e level)
+{
+    scan_level_e supported = supported_level();
+    int used = level < supported ? level : supported;
+    STORE_LEVEL(&g_level, used);
+    return (scan_level_e)used;
+}
+
+scan_class_e scan_classify(const char* token)
+{
+    if (token[0] != '-' || token[1] == '\0')
+        return SCAN_OPERAND;
+    if (token[1] != '-')
+        return SCAN_SHORT;
+    return token[2] == '\0' ? SCAN_END_OF_OPTIONS : SCAN_LONG;
+}
+
+////////////
+// Scalar //
+////////////
+
+static size_t find_scalar(const char* text, char c)
+{
+    const char* p = text;
+    while (*p != '\0' && *p != c)
+    {
+        p++;
+    }
+    return (size_t)(p - text);
+}
+
+static int is_special(unsigned char c, char quote)
+{
+    if (quote == '\'')
+        return c == '\'';
+    if (quote == '"')
+        return c == '"' || c == '\\';
+    return c == ' ' || (c >= '\t' && c <= '\r') || c == '\'' || c == '"' || c == '\\';
+}
+
+static size_t plain_scalar(const char* text, const char* end, char quote)
+{
+    const char* p = text;
+    while (p < end && !is_special((unsigned char)*p, quote))
+    {
+        p++;
+    }
+    return (size_t)(p - text);
+}
+
+#if SCAN_X86
+
+//////////
+// SSE2 //
+//////////
+
+/// @brief first c or NUL, from aligned blocks so no load crosses a page
+SCAN_OVERREAD static size_t find_sse2(const char* text, char c)
+{
+    const __m128i zero = _mm_setzero_si128();
+    const __m128i wanted = _mm_set1_epi8(c);
+    size_t offset = (uintptr_t)text & 15;
+    const __m128i* block = (const __m128i*)(text - offset);
+    __m128i x = _mm_load_si128(block);
+    uint32_t mask = (uint32_t)_mm_movemask_epi8(_mm_or_si128(_mm_cmpeq_epi8(x, zero), _mm_cmpeq_epi8(x, wanted))) >> offset;
+    if (mask)
+        return (size_t)lowest_bit(mask);
+
+    size_t found = 16 - offset;
+    for (;;)
+    {
+        x = _mm_load_si128(++block);
+        mask = (uint32_t)_mm_movemask_epi8(_mm_or_si128(_mm_cmpeq_epi8(x, zero), _mm_cmpeq_epi8(x, wanted)));
+        if (mask)
+            return found + lowest_bit(mask);
+        found += 16;
+    }
+}
+
+static __m128i special_sse2(__m128i x, char quote)
+{
+    __m128i hit = _mm_cmpeq_epi8(x, _mm_set1_epi8(quote == '\'' ? '\'' : '\\'));
+    if (quote == '\'')
+        return hit;
+
+    hit = _mm_or_si128(hit, _mm_cmpeq_epi8(x, _mm_set1_epi8('"')));
+    if (quote == '"')
+        return hit;
+
+    // '\t'..'\r' as x - '\t' <= 4 unsigned
+    __m128i shifted = _mm_sub_epi8(x, _mm_set1_epi8('\t'));
+    __m128i control = _mm_cmpeq_epi8(_mm_min_epu8(shifted, _mm_set1_epi8(4)), shifted);
+    hit = _mm_or_si128(hit, control);
+    hit = _mm_or_si128(hit, _mm_cmpeq_epi8(x, _mm_set1_epi8(' ')));
+    return _mm_or_si128(hit, _mm_cmpeq_epi8(x, _mm_set1_epi8('\'')));
+}
+
+static size_t plain_sse2(const char* text, const char* end, char quote)
+{
+    const char* p = text;
+    while (end - p >= 16)
+    {
+        uint32_t mask = (uint32_t)_mm_movemask_epi8(special_sse2(_mm_loadu_si128((const __m128i*)p), quote));
+        if (mask)
+            return (size_t)(p - text) + lowest_bit(mask);
+        p += 16;
+    }
+    return (size_t)(p - text) + plain_scalar(p, end, quote);
+}
+
+//////////
+// AVX2 //
+//////////
+
+SCAN_AVX2_TARGET SCAN_OVERREAD static size_t find_avx2(const char* text, char c)
+{
+    const __m256i zero = _mm256_setzero_si256();
+    const __m256i wanted = _mm256_set1_epi8(c);
+    size_t offset = (uintptr_t)text & 31;
+    const __m256i* block = (const __m256i*)(text - offset);
+    __m256i x = _mm256_load_si256(block);
+    // shifting a 32 bit mask by up to 31 is defined
+    uint32_t mask = (uint32_t)_mm256_movemask_epi8(_mm256_or_si256(_mm256_cmpeq_epi8(x, zero), _mm256_cmpeq_epi8(x, wanted))) >> offset;
+    if (mask)
+        return (size_t)lowest_bit(mask);
+
+    size_t found = 32 - offset;
+    for (;;)
+    {
+        x = _mm256_load_si256(++block);
+        mask = (uint32_t)_mm256_movemask_epi8(_mm256_or_si256(_mm256_cmpeq_epi8(x, zero), _mm256_cmpeq_epi8(x, wanted)));
+        if (mask)
+            return found + lowest_bit(mask);
+        found += 32;
+    }
+}
+
+SCAN_AVX2_TARGET static __m256i special_avx2(__m256i x, char quote)
+{
+    __m256i hit = _mm256_cmpeq_epi8(x, _mm256_set1_epi8(quote == '\'' ? '\'' : '\\'));
+    if (quote == '\'')
+        return hit;
+
+    hit = _mm256_or_si256(hit, _mm256_cmpeq_epi8(x, _mm256_set1_epi8('"')));
+    if (quote == '"')
+        return hit;
+
+    __m256i shifted = _mm256_sub_epi8(x, _mm256_set1_epi8('\t'));
+    __m256i control = _mm256_cmpeq_epi8(_mm256_min_epu8(shifted, _mm256_set1_epi8(4)), shifted);
+    hit = _mm256_or_si256(hit, control);
+    hit = _mm256_or_si256(hit, _mm256_cmpeq_epi8(x, _mm256_set1_epi8(' ')));
+    return _mm256_or_si256(hit, _mm256_cmpeq_epi8(x, _mm256_set1_epi8('\'')));
+}
+
+SCAN_AVX2_TARGET static size_t plain_avx2(const char* text, const char* end, char quote)
+{
+    const char* p = text;
+    while (end - p >= 32)
+    {
+        uint32_t mask = (uint32_t)_mm256_movemask_epi8(special_avx2(_mm256_loadu_si256((const __m256i*)p), quote));
+        if (mask)
+            return (size_t)(p - text) + lowest_bit(mask);
+        p += 32;
+    }
+    return (size_t)(p - text) + plain_sse2(p, end, quote);
+}
+
+#endif
+
+//////////////
+// Dispatch //
+//////////////
+
+static size_t find(const char* text, char c)
+{
+#if SCAN_X86
+    switch (scan_level())
+    {
+        case SCAN_AVX2:
+            return find_avx2(text, c);
+        case SCAN_SSE2:
+            return find_sse2(text, c);
+        default:
+            break;
+    }
+#endif
+    return find_scalar(text, c);
+}
+
+size_t scan_length(const char* text)
+{
+    return find(text, '\0');
+}
+
+size_t scan_name_end(const char* text)
+{
+    return find(text, '=');
+}
+
+size_t scan_plain(const char* text, const char* end, char quote)
+{
+#if SCAN_X86
+    switch (scan_level())
+    {
+        case SCAN_AVX2:
+            return plain_avx2(text, end, quote);
+        case SCAN_SSE2:
+            return plain_sse2(text, end, quote);
+        default:
+            break;
+    }
+#endif
+    return plain_scalar(text, end, quote);
+}
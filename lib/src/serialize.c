@@ -0,0 +1,240 @@
+#include "serialize.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#if defined(_WIN32)
+#include <io.h>
+#else
+#include <errno.h>
+#include <unistd.h>
+#endif
+
+/// @brief string area cursor, measures only when buffer is NULL
+typedef struct _image_writer
+{
+    char* buffer;
+    size_t length;
+} image_writer_t;
+
+static uint32_t put_string(image_writer_t* writer, const char* s)
+{
+    if (s == NULL)
+        return 0;
+
+    size_t length = strlen(s) + 1;
+    size_t offset = writer->length;
+    if (writer->buffer)
+        memcpy(writer->buffer + offset, s, length);
+    writer->length += length;
+    // oversized images are rejected once measured
+    return (uint32_t)offset;
+}
+
+static size_t write_image(ARG_DATA_HANDLE handle, char* buffer)
+{
+    image_writer_t writer = {buffer, sizeof(image_header_t) + handle->count * sizeof(image_entry_t)};
+    image_header_t header;
+    memset(&header, 0, sizeof(header));
+    memcpy(header.magic, IMAGE_MAGIC, sizeof(header.magic));
+    header.version = IMAGE_VERSION;
+    header.byte_order = IMAGE_BYTE_ORDER;
+    header.count = (uint32_t)handle->count;
+    header.flags = (uint32_t)handle->flags;
+    header.title = put_string(&writer, handle->title);
+    header.env_prefix = put_string(&writer, handle->env_prefix);
+
+    for (int i = 0; i < handle->count; i++)
+    {
+        ARG_ARGUMENT_HANDLE arg = handle->arguments[i];
+        image_entry_t entry;
+        memset(&entry, 0, sizeof(entry));
+        entry.name = put_string(&writer, arg->name);
+        entry.description = put_string(&writer, arg->description);
+        entry.env = put_string(&writer, arg->env);
+        entry.type = arg->type;
+        entry.parsed = arg->parsed;
+        entry.name_short = (unsigned char)arg->name_short;
+        switch (arg->type)
+        {
+            case ARGSPARSE_TYPE_STRING:
+                entry.string = put_string(&writer, arg->value.stringvalue);
+                break;
+            case ARGSPARSE_TYPE_INT:
+                entry.integer = arg->value.intvalue;
+                break;
+            case ARGSPARSE_TYPE_DOUBLE:
+                entry.real = arg->value.doublevalue;
+                break;
+            case ARGSPARSE_TYPE_FLAG:
+                // the target is a pointer of this process, keep the value
+                entry.integer = arg->value.flagptr ? *arg->value.flagptr : 0;
+                entry.flagvalue = arg->flag_init.flagvalue;
+                break;
+            default:
+                break;
+        }
+        if (buffer)
+            memcpy(buffer + sizeof(image_header_t) + i * sizeof(image_entry_t), &entry, sizeof(entry));
+    }
+
+    // closing terminator, also for an image without strings
+    if (buffer)
+        buffer[writer.length] = '\0';
+    writer.length++;
+
+    header.size = writer.length;
+    if (buffer)
+        memcpy(buffer, &header, sizeof(header));
+    return writer.length;
+}
+
+size_t image_write(ARG_DATA_HANDLE handle, void* buffer, size_t size)
+{
+    size_t required = write_image(handle, NULL);
+    if (required > UINT32_MAX)
+        return 0;
+
+    if (buffer && size >= required)
+        write_image(handle, buffer);
+    return required;
+}
+
+ARG_ERROR image_write_fd(ARG_DATA_HANDLE handle, int fd)
+{
+    size_t size = image_write(handle, NULL, 0);
+    if (size == 0)
+        return ERROR_AP_RANGE;
+
+    char* buffer = malloc(size);
+    if (buffer == NULL)
+        return ERROR_AP_MEMORY;
+
+    image_write(handle, buffer, size);
+    size_t written = 0;
+    while (written < size)
+    {
+#if defined(_WIN32)
+        int n = _write(fd, buffer + written, (unsigned int)(size - written));
+#else
+        ssize_t n = write(fd, buffer + written, size - written);
+        if (n < 0 && errno == EINTR)
+            continue;
+#endif
+        if (n <= 0)
+            break;
+        written += (size_t)n;
+    }
+    free(buffer);
+    return written == size ? ERROR_AP_NONE : ERROR_AP_FILE;
+}
+
+ARG_ERROR cache_write(ARG_DATA_HANDLE handle, const char* path, uint64_t key)
+{
+    size_t size = image_write(handle, NULL, 0);
+    if (size == 0)
+        return ERROR_AP_RANGE;
+
+    size_t path_length = strlen(path);
+    char* block = malloc(sizeof(cache_header_t) + size + path_length + sizeof(".tmp"));
+    if (block == NULL)
+        return ERROR_AP_MEMORY;
+
+    cache_header_t header;
+    memcpy(header.magic, CACHE_MAGIC, sizeof(header.magic));
+    header.key = key;
+    memcpy(block, &header, sizeof(header));
+    image_write(handle, block + sizeof(header), size);
+    size += sizeof(header);
+
+    char* temporary = block + size;
+    memcpy(temporary, path, path_length);
+    memcpy(temporary + path_length, ".tmp", sizeof(".tmp"));
+
+    ARG_ERROR error = ERROR_AP_FILE;
+    FILE* file = fopen(temporary, "wb");
+    if (file)
+    {
+        int written = fwrite(block, 1, size, file) == size;
+        if (fclose(file) == 0 && written)
+        {
+#if defined(_WIN32)
+            // rename does not replace on Windows
+            remove(path);
+#endif
+            if (rename(temporary, path) == 0)
+                error = ERROR_AP_NONE;
+        }
+        if (error != ERROR_AP_NONE)
+            remove(temporary);
+    }
+    free(block);
+    return error;
+}
+
+const void* cache_image(const file_map_t* map, uint64_t key, size_t* size)
+{
+    cache_header_t header;
+    if (map->size <= sizeof(header))
+        return NULL;
+
+    memcpy(&header, map->data, sizeof(header));
+    if (memcmp(header.magic, CACHE_MAGIC, sizeof(header.magic)) != 0 || header.key != key)
+        return NULL;
+
+    *size = map->size - sizeof(header);
+    return map->data + sizeof(header);
+}
+
+/// @brief offset is 0 or in the string area
+static int valid_string(const image_header_t* header, size_t strings, uint32_t offset)
+{
+    return offset == 0 || (offset >= strings && offset < header->size);
+}
+
+int image_validate(const void* image, size_t size, image_header_t* header)
+{
+    if (image == NULL || size < sizeof(image_header_t) + 1 || size > UINT32_MAX)
+        return 0;
+
+    memcpy(header, image, sizeof(image_header_t));
+    if (memcmp(header->magic, IMAGE_MAGIC, sizeof(header->magic)) != 0
+        || header->version != IMAGE_VERSION
+        || header->byte_order != IMAGE_BYTE_ORDER
+        || header->size != size
+        || header->count > (size - sizeof(image_header_t)) / sizeof(image_entry_t)
+        || ((const char*)image)[size - 1] != '\0')
+        return 0;
+
+    size_t strings = sizeof(image_header_t) + header->count * sizeof(image_entry_t);
+    if (!valid_string(header, strings, header->title) || !valid_string(header, strings, header->env_prefix))
+        return 0;
+
+    for (uint32_t i = 0; i < header->count; i++)
+    {
+        image_entry_t entry;
+        image_entry(image, (int)i, &entry);
+        if (entry.name == 0 || entry.description == 0
+            || !valid_string(header, strings, entry.name)
+            || !valid_string(header, strings, entry.description)
+            || !valid_string(header, strings, entry.env)
+            || !valid_string(header, strings, entry.string)
+            || entry.type < ARGSPARSE_TYPE_NONE || entry.type >= ARGSPARSE_TYPE_CNT
+            || entry.parsed < ARGSPARSE_SOURCE_DEFAULT || entry.parsed > ARGSPARSE_SOURCE_ENV
+            || entry.name_short < 0 || entry.name_short > 255)
+            return 0;
+    }
+    return 1;
+}
+
+void image_entry(const void* image, int index, image_entry_t* entry)
+{
+    // a caller's buffer need not be aligned for the entry
+    memcpy(entry, (const char*)image + sizeof(image_header_t) + index * sizeof(image_entry_t), sizeof(image_entry_t));
+}
+
+const char* image_string(const void* image, uint32_t offset)
+{
+    return offset ? (const char*)image + offset : NULL;
+}
@@ -0,0 +1,30 @@
+#include "string_pool.h"
+
+#include <string.h>
+
+const char* string_pool_intern(string_pool_t* pool, const char* str, size_t length)
+{
+    uint32_t hash = name_hash(str, length);
+    char* pooled = name_index_find(&pool->strings, str, length, hash);
+    if (pooled == NULL)
+    {
+        pooled = arena_alloc(pool->arena, length + 1);
+        if (pooled == NULL)
+        {
+            return NULL;
+        }
+        memcpy(pooled, str, length);
+        pooled[length] = '\0';
+        if (name_index_insert(&pool->strings, pooled, length, hash, pooled) != ERROR_AP_NONE)
+        {
+            // still usable, only not shared
+            return pooled;
+        }
+    }
+    return pooled;
+}
+
+void string_pool_free(string_pool_t* pool)
+{
+    name_index_free(&pool->strings);
+}
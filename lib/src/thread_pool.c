@@ -0,0 +1,141 @@
+#include "thread_pool.h"
+
+#include <stdlib.h>
+
+#if defined(_WIN32)
+#include <windows.h>
+#else
+#include <pthread.h>
+#include <unistd.h>
+#endif
+
+#define CACHE_LINE 64
+
+/// @brief indices [next, end) not yet claimed, padded against false sharing
+typedef struct _work_range
+{
+    volatile int next;
+    int end;
+    char padding[CACHE_LINE - 2 * sizeof(int)];
+} work_range_t;
+
+typedef struct _worker
+{
+    work_range_t* ranges;
+    int count;
+    int self;
+    thread_task_fn task;
+    void* context;
+} worker_t;
+
+static void run_worker(worker_t* worker)
+{
+    // own range first, then the others starting from the next one
+    for (int offset = 0; offset < worker->count; offset++)
+    {
+        work_range_t* range = &worker->ranges[(worker->self + offset) % worker->count];
+        int index;
+        while ((index = FETCH_ADD(&range->next, 1)) < range->end)
+        {
+            worker->task(worker->context, index);
+        }
+    }
+}
+
+#if defined(_WIN32)
+static DWORD WINAPI thread_main(LPVOID data)
+{
+    run_worker(data);
+    return 0;
+}
+#else
+static void* thread_main(void* data)
+{
+    run_worker(data);
+    return NULL;
+}
+#endif
+
+int thread_pool_cpu_count()
+{
+#if defined(_WIN32)
+    SYSTEM_INFO info;
+    GetSystemInfo(&info);
+    int count = (int)info.dwNumberOfProcessors;
+#else
+    int count = (int)sysconf(_SC_NPROCESSORS_ONLN);
+#endif
+    return count > 0 ? count : 1;
+}
+
+void thread_pool_run(int count, int nthreads, thread_task_fn task, void* context)
+{
+    if (nthreads <= 0)
+        nthreads = thread_pool_cpu_count();
+    if (nthreads > count)
+        nthreads = count;
+
+    work_range_t* ranges = nthreads > 1 ? malloc(nthreads * sizeof(work_range_t)) : NULL;
+    worker_t* workers = nthreads > 1 ? malloc(nthreads * sizeof(worker_t)) : NULL;
+#if defined(_WIN32)
+    HANDLE* threads = nthreads > 1 ? malloc(nthreads * sizeof(HANDLE)) : NULL;
+#else
+    pthread_t* threads = nthreads > 1 ? malloc(nthreads * sizeof(pthread_t)) : NULL;
+    char* started = nthreads > 1 ? calloc(nthreads, 1) : NULL;
+#endif
+    if (ranges == NULL || workers == NULL || threads == NULL
+#if !defined(_WIN32)
+        || started == NULL
+#endif
+        )
+    {
+        // single threaded
+        for (int index = 0; index < count; index++)
+        {
+            task(context, index);
+        }
+    }
+    else
+    {
+        for (int i = 0; i < nthreads; i++)
+        {
+            ranges[i].next = (int)((long long)count * i / nthreads);
+            ranges[i].end = (int)((long long)count * (i + 1) / nthreads);
+            workers[i].ranges = ranges;
+            workers[i].count = nthreads;
+            workers[i].self = i;
+            workers[i].task = task;
+            workers[i].context = context;
+        }
+
+        for (int i = 1; i < nthreads; i++)
+        {
+#if defined(_WIN32)
+            threads[i] = CreateThread(NULL, 0, thread_main, &workers[i], 0, NULL);
+#else
+            started[i] = pthread_create(&threads[i], NULL, thread_main, &workers[i]) == 0;
+#endif
+        }
+        run_worker(&workers[0]);
+        for (int i = 1; i < nthreads; i++)
+        {
+#if defined(_WIN32)
+            if (threads[i])
+            {
+                WaitForSingleObject(threads[i], INFINITE);
+                CloseHandle(threads[i]);
+            }
+#else
+            if (started[i])
+                pthread_join(threads[i], NULL);
+#endif
+        }
+    }
+
+#if !defined(_WIN32)
+    free(started);
+#endif
+    free(threads);
+    free(workers);
+    free(ranges);
+}
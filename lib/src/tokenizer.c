@@ -0,0 +1,89 @@
+#include "tokenizer.h"
+#include "scan.h"
+
+#include <string.h>
+
+static int is_space(char c)
+{
+    return c == ' ' || c == '\t' || c == '\n' || c == '\r' || c == '\v' || c == '\f';
+}
+
+void tokenizer_init(tokenizer_t* tokenizer, char* text, size_t length)
+{
+    tokenizer->next = text;
+    tokenizer->end = text + length;
+    tokenizer->unterminated = 0;
+}
+
+char* tokenizer_next(tokenizer_t* tokenizer)
+{
+    char* read = tokenizer->next;
+    char* end = tokenizer->end;
+    while (read < end && is_space(*read))
+    {
+        read++;
+    }
+    if (read == end)
+    {
+        tokenizer->next = end;
+        return NULL;
+    }
+
+    // write never passes read, unquoted text is only moved left
+    char* token = read;
+    char* write = read;
+    char quote = 0;
+    for (; read < end; read++)
+    {
+        // copy the run of ordinary bytes up to the next one that matters
+        size_t run = scan_plain(read, end, quote);
+        if (run)
+        {
+            if (write != read)
+                memmove(write, read, run);
+            write += run;
+            read += run;
+            if (read == end)
+                break;
+        }
+
+        char c = *read;
+        if (quote == '\'')
+        {
+            if (c == '\'')
+                quote = 0;
+            else
+                *write++ = c;
+        }
+        else if (c == '\\' && read + 1 < end &&
+            (quote == 0 || read[1] == '"' || read[1] == '\\' || read[1] == '$' || read[1] == '`'))
+        {
+            *write++ = *++read;
+        }
+        else if (quote == '"')
+        {
+            if (c == '"')
+                quote = 0;
+            else
+                *write++ = c;
+        }
+        else if (c == '\'' || c == '"')
+        {
+            quote = c;
+        }
+        else if (is_space(c))
+        {
+            break;
+        }
+        else
+        {
+            *write++ = c;
+        }
+    }
+
+    // an unterminated quote runs to the end of the text
+    tokenizer->unterminated |= quote != 0;
+    tokenizer->next = read < end ? read + 1 : end;
+    *write = '\0';
+    return token;
+}
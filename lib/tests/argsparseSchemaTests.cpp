@@ -0,0 +1,132 @@
+/**
+ * @file argsparseSchemaTests.cpp
+ * @author Tuomas Lahtinen (tuomas123lahtinen@gmail.com)
+ * @brief 
+ * 
+ * @copyright Copyright (c) 2023
+ * 
+ */
+
+#include "argsparse.hpp"
+
+#include "gtest/gtest.h"
+#include <cstring>
+#include <string>
+
+namespace argsparse::testing
+{
+#define TEST_FIXTURE argsparse_schema_test
+
+class TEST_FIXTURE : public ::testing::Test
+{
+};
+
+static constexpr auto kSchema = make_schema(
+    help_option(),
+    int_option("integer", "This is an integer", 5),
+    double_option("double", "This is a double", 1.5),
+    string_option("string", "This is a string", "default"),
+    flag_option("flag", "This is a flag", 2),
+    int_option("index", "This is an explicit short", 0, 'x'));
+
+// resolved by the compiler
+static_assert(kSchema.find("integer") == 1);
+static_assert(kSchema.find("intege") == -1);
+static_assert(kSchema.find("unknown") == -1);
+static_assert(kSchema.index("flag") == 4);
+static_assert(kSchema.find_short('x') == 5);
+static_assert(kSchema.find_short('f') == -1);
+
+static constexpr auto kLarge = make_schema(
+    flag_option("alpha", "", 1), flag_option("bravo", "", 1), flag_option("charlie", "", 1),
+    flag_option("delta", "", 1), flag_option("echo", "", 1), flag_option("foxtrot", "", 1),
+    flag_option("golf", "", 1), flag_option("hotel", "", 1), flag_option("india", "", 1),
+    flag_option("juliett", "", 1), flag_option("kilo", "", 1), flag_option("lima", "", 1),
+    flag_option("mike", "", 1), flag_option("november", "", 1), flag_option("oscar", "", 1),
+    flag_option("papa", "", 1), flag_option("quebec", "", 1), flag_option("romeo", "", 1),
+    flag_option("sierra", "", 1), flag_option("tango", "", 1), flag_option("uniform", "", 1),
+    flag_option("victor", "", 1), flag_option("whiskey", "", 1), flag_option("xray", "", 1),
+    flag_option("yankee", "", 1), flag_option("zulu", "", 1), flag_option("a", "", 1),
+    flag_option("ab", "", 1), flag_option("abc", "", 1), flag_option("abcd", "", 1));
+
+TEST_F(TEST_FIXTURE, ShouldGenerateShortOptionsLikeTheCApi)
+{
+    // 'h' help, 'i' integer, 'd' double, 's' string, no flag, explicit 'x'
+    EXPECT_STREQ(kSchema.shortopts.data(), "hi:d:s:x:");
+    EXPECT_EQ(kSchema.options[1].short_name, 'i');
+    EXPECT_EQ(kSchema.options[4].short_name, 0);
+}
+
+TEST_F(TEST_FIXTURE, ShouldHashAllNamesWithoutCollisions)
+{
+    for (std::size_t i = 0; i < kLarge.size; i++)
+    {
+        EXPECT_EQ(kLarge.find(kLarge.options[i].name), static_cast<int>(i));
+        EXPECT_EQ(kLarge.find(std::string(kLarge.options[i].name) + "_"), -1);
+    }
+}
+
+TEST_F(TEST_FIXTURE, ShouldHaveDefaultsBeforeParsing)
+{
+    parser<kSchema> args;
+    EXPECT_EQ(ARGSPARSE_GET(args, "integer"), 5);
+    EXPECT_EQ(ARGSPARSE_GET(args, "double"), 1.5);
+    EXPECT_EQ(ARGSPARSE_GET(args, "string"), "default");
+    EXPECT_EQ(ARGSPARSE_GET(args, "flag"), 0);
+    EXPECT_FALSE(ARGSPARSE_PARSED(args, "integer"));
+}
+
+TEST_F(TEST_FIXTURE, ShouldParseTypedValues)
+{
+    char arg0[] = "app", arg1[] = "-i42", arg2[] = "--double=-2.25", arg3[] = "--str",
+         arg4[] = "text", arg5[] = "--flag", arg6[] = "-x", arg7[] = "+7", arg8[] = "operand";
+    char* argv[] = { arg0, arg1, arg2, arg3, arg4, arg5, arg6, arg7, arg8 };
+
+    parser<kSchema> args;
+    EXPECT_EQ(args.parse(9, argv), 5);
+    EXPECT_EQ(ARGSPARSE_GET(args, "integer"), 42);
+    EXPECT_EQ(ARGSPARSE_GET(args, "double"), -2.25);
+    EXPECT_EQ(ARGSPARSE_GET(args, "string"), "text");
+    EXPECT_EQ(ARGSPARSE_GET(args, "string").data(), arg4);
+    EXPECT_EQ(ARGSPARSE_GET(args, "flag"), 2);
+    EXPECT_EQ(ARGSPARSE_GET(args, "index"), 7);
+    EXPECT_TRUE(ARGSPARSE_PARSED(args, "flag"));
+    EXPECT_FALSE(ARGSPARSE_GET(args, "help"));
+
+    args.reset();
+    EXPECT_EQ(ARGSPARSE_GET(args, "integer"), 5);
+    EXPECT_FALSE(ARGSPARSE_PARSED(args, "flag"));
+}
+
+TEST_F(TEST_FIXTURE, ShouldReportErrors)
+{
+    char arg0[] = "app", unknown[] = "--unknown", ambiguous[] = "--in", missing[] = "-i",
+         format[] = "--integer=4x", range[] = "--integer=99999999999", flagvalue[] = "--flag=1",
+         real_format[] = "--double=2.5x", real_range[] = "--double=1e400";
+    struct
+    {
+        char* arg;
+        int expected;
+    } cases[] = {
+        { unknown, ERROR_AP_UNKNOWN },
+        { ambiguous, ERROR_AP_UNKNOWN },
+        { missing, ERROR_AP_UNKNOWN },
+        { format, ERROR_AP_FORMAT },
+        { range, ERROR_AP_RANGE },
+        { flagvalue, ERROR_AP_UNKNOWN },
+        { real_format, ERROR_AP_FORMAT },
+        { real_range, ERROR_AP_RANGE },
+    };
+
+    for (auto& c : cases)
+    {
+        char* argv[] = { arg0, c.arg };
+        parser<kSchema> args;
+        EXPECT_EQ(args.parse(2, argv), c.expected) << c.arg;
+        // rejected values leave the defaults
+        EXPECT_EQ(ARGSPARSE_GET(args, "integer"), 5) << c.arg;
+        EXPECT_EQ(ARGSPARSE_GET(args, "double"), 1.5) << c.arg;
+    }
+}
+
+} // namespace argsparse::testing
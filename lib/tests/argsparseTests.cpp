@@ -9,13 +9,24 @@
 
 #include "argsparse.h"
 #include "tokenize.h"
+extern "C"
+{
+#include "internal_types.h"
+#include "scan.h"
+}
 
 #include "gtest/gtest.h"
 #include "gmock/gmock.h"
 #include "gtest/gtest-matchers.h"
 #include <sstream>
 #include <ostream>
+#include <climits>
+#include <cstdio>
+#include <fstream>
 #include <memory>
+#include <string>
+#include <thread>
+#include <vector>
 
 #if defined(__linux__)
 #define ExitCode(a) ((a) < 0 ? (a) + 256 : (a))
@@ -50,7 +61,7 @@ public:
     TestParams(ARG_TYPE type, const char* string)
     {
         Type = type;
-        memcpy(&Value.stringvalue, string, strlen(string));
+        Value.stringvalue = string;
     }
 
     TestParams(ARG_TYPE type, double value)
@@ -169,6 +180,45 @@ TEST_F(TEST_FIXTURE, ShouldNotAppendSameOption)
     ASSERT_STREQ("i:", shortopts);
 }
 
+TEST_F(TEST_FIXTURE, ShouldFindArgumentsByName)
+{
+    const int count = 1000;
+    char name[ARGSPARSE_MAX_STRING_SIZE];
+    assert_create_arguments();
+    for (int i = 0; i < count; i++)
+    {
+        sprintf(name, "integer%d", i);
+        ASSERT_EQ(ERROR_AP_NONE, argsparse_add_int(name, "description", i));
+    }
+
+    for (int i = 0; i < count; i++)
+    {
+        sprintf(name, "integer%d", i);
+        ARG_ARGUMENT_HANDLE arg = argsparse_argument_by_name(name);
+        ASSERT_THAT(arg, NotNull());
+        ASSERT_STREQ(name, arg->name);
+        ASSERT_EQ(i, arg->value.intvalue);
+    }
+    ASSERT_THAT(argsparse_argument_by_name("integer"), IsNull());
+    ASSERT_EQ(count, argsparse_argument_count());
+}
+
+TEST_F(TEST_FIXTURE, ShouldGenerateUnusedShortNames)
+{
+    assert_create_arguments();
+    ASSERT_EQ(ERROR_AP_NONE, argsparse_add_int("abba", "description", 0));
+    ASSERT_EQ(ERROR_AP_NONE, argsparse_add_int("baba", "description", 0));
+    ASSERT_EQ(ERROR_AP_NONE, argsparse_add_flag("flag", "description", 1, nullptr));
+    ASSERT_EQ(ERROR_AP_NONE, argsparse_add_int("ab", "description", 0));
+    ASSERT_STREQ("a:b:c:", argsparse_get_shortopts());
+
+    ASSERT_EQ(argsparse_argument_by_name("abba"), argsparse_argument_by_short_name('a'));
+    ASSERT_EQ(argsparse_argument_by_name("baba"), argsparse_argument_by_short_name('b'));
+    ASSERT_EQ(argsparse_argument_by_name("ab"), argsparse_argument_by_short_name('c'));
+    ASSERT_THAT(argsparse_argument_by_short_name('f'), IsNull());
+    ASSERT_THAT(argsparse_argument_by_short_name(0), IsNull());
+}
+
 TEST_F(TEST_FIXTURE, ParsesAllOptionTypes)
 {
     int flgValue = 0;
@@ -388,16 +438,11 @@ TEST_F(TEST_FIXTURE, SplitsWhitespaceString)
 
 TEST_F(TEST_FIXTURE, ShouldParseDoubleQuotedWhitespaceString)
 {
-    int argc = 0;
     const char* defvalue = "1234.4321";
     const char* expvalue = "4321 1234";
-    // tokenise_to_argc_argv does handle double quoted string
-    // will have to do it manually
-    char buffer[50] = "program\000--string\0004321 1234";
-    gArgv[0] = buffer;
-    gArgv[1] = buffer + 8;
-    gArgv[2] = buffer + 17;
-    argc = 3;
+    char buffer[50] = "program --string \"4321 1234\"";
+    int argc = argsparse_tokenize(buffer, gArgv, ARGV_SIZE);
+    ASSERT_EQ(3, argc);
     print_arguments(gArgv, argc);
 
     assert_create_arguments();
@@ -410,6 +455,276 @@ TEST_F(TEST_FIXTURE, ShouldParseDoubleQuotedWhitespaceString)
     ASSERT_EQ(0, strncmp(expvalue, arg->value.stringvalue, strlen(expvalue)));
 }
 
+TEST_F(TEST_FIXTURE, ScansShouldAgreeAtEveryLevel)
+{
+    const char alphabet[] = "ab=-\\'\" \t\n\rxyz0";
+    alignas(64) char buffer[256];
+    unsigned seed = 12345;
+    for (int level = SCAN_SCALAR; level <= SCAN_AVX2; level++)
+    {
+        if (scan_set_level((scan_level_e)level) != level)
+            continue;
+
+        for (int round = 0; round < 2000; round++)
+        {
+            size_t offset = round % 64;
+            size_t length = (round * 7) % 150;
+            for (size_t i = 0; i < length; i++)
+            {
+                seed = seed * 1103515245u + 12345u;
+                // mostly ordinary bytes, for runs longer than a vector
+                char c = (seed >> 16) % 8 ? 'a' + (char)((seed >> 8) % 26) : alphabet[(seed >> 20) % (sizeof(alphabet) - 1)];
+                buffer[offset + i] = c;
+            }
+            buffer[offset + length] = '\0';
+            const char* text = buffer + offset;
+            size_t terminated = strlen(text);
+
+            ASSERT_EQ(terminated, scan_length(text)) << "level " << level;
+            ASSERT_EQ(strcspn(text, "="), scan_name_end(text)) << "level " << level;
+            ASSERT_EQ(strcspn(text, " \t\n\v\f\r'\"\\"), scan_plain(text, text + terminated, 0)) << "level " << level;
+            ASSERT_EQ(strcspn(text, "\"\\"), scan_plain(text, text + terminated, '"')) << "level " << level;
+            ASSERT_EQ(strcspn(text, "'"), scan_plain(text, text + terminated, '\'')) << "level " << level;
+        }
+    }
+    scan_set_level(SCAN_AVX2);
+}
+
+TEST_F(TEST_FIXTURE, ShouldTokenizeShellQuoting)
+{
+    char buffer[BUFFER_SIZE] = "  program 'a \"b\"' \"c \\\" \\$d\"\te\\ f g''h \"\"";
+    char* argv[ARGV_SIZE];
+    ASSERT_EQ(6, argsparse_tokenize(buffer, argv, ARGV_SIZE));
+    EXPECT_STREQ("program", argv[0]);
+    EXPECT_STREQ("a \"b\"", argv[1]);
+    EXPECT_STREQ("c \" $d", argv[2]);
+    EXPECT_STREQ("e f", argv[3]);
+    EXPECT_STREQ("gh", argv[4]);
+    EXPECT_STREQ("", argv[5]);
+    EXPECT_THAT(argv[6], IsNull());
+    // in place
+    EXPECT_GE(argv[5], buffer);
+    EXPECT_LT(argv[5], buffer + sizeof(buffer));
+
+    // counted beyond the capacity
+    char many[BUFFER_SIZE] = "a b c d";
+    ASSERT_EQ(4, argsparse_tokenize(many, argv, 3));
+    EXPECT_STREQ("b", argv[1]);
+    EXPECT_THAT(argv[2], IsNull());
+
+    char open_quote[BUFFER_SIZE] = "program \"unterminated";
+    EXPECT_EQ(ERROR_AP_FORMAT, argsparse_tokenize(open_quote, argv, ARGV_SIZE));
+    char empty[BUFFER_SIZE] = " \t ";
+    EXPECT_EQ(0, argsparse_tokenize(empty, argv, ARGV_SIZE));
+    EXPECT_THAT(argv[0], IsNull());
+    EXPECT_EQ(ERROR_AP_HANDLE, argsparse_tokenize(nullptr, argv, ARGV_SIZE));
+}
+
+TEST_F(TEST_FIXTURE, ShouldParseAttachedShortValueAndLongPrefix)
+{
+    sprintf(gBuffer, "program -i4321 --doub=1.5 -- --string operand");
+    tokenise_to_argc_argv(gBuffer, &gArgc, gArgv, ARGV_SIZE, print_arguments);
+
+    assert_create_arguments();
+    argsparse_add_int("integer", "This is an integer", 1234);
+    argsparse_add_double("double", "This is a double", 1234.4321);
+    argsparse_add_cstr("string", "This is a string", "default");
+    ASSERT_EQ(2, argsparse_parse_args(gArgv, gArgc));
+    ASSERT_EQ(4321, argsparse_argument_by_name("integer")->value.intvalue);
+    ASSERT_DOUBLE_EQ(1.5, argsparse_argument_by_name("double")->value.doublevalue);
+    ASSERT_EQ(0, argsparse_argument_by_name("string")->parsed);
+}
+
+TEST_F(TEST_FIXTURE, ExitWhenInvalidOption)
+{
+    sprintf(gBuffer, "program --in 1");
+    tokenise_to_argc_argv(gBuffer, &gArgc, gArgv, ARGV_SIZE, print_arguments);
+
+    assert_create_arguments();
+    argsparse_add_int("integer", "This is an integer", 1234);
+    argsparse_add_int("interval", "This is an integer", 1234);
+    ASSERT_EXIT(argsparse_parse_args(gArgv, gArgc), ::testing::ExitedWithCode(1), "option '--in' is ambiguous");
+
+    sprintf(gBuffer, "program -x");
+    tokenise_to_argc_argv(gBuffer, &gArgc, gArgv, ARGV_SIZE, print_arguments);
+    ASSERT_EXIT(argsparse_parse_args(gArgv, gArgc), ::testing::ExitedWithCode(1), "invalid option -- 'x'");
+
+    sprintf(gBuffer, "program --integer");
+    tokenise_to_argc_argv(gBuffer, &gArgc, gArgv, ARGV_SIZE, print_arguments);
+    ASSERT_EXIT(argsparse_parse_args(gArgv, gArgc), ::testing::ExitedWithCode(1), "option '--integer' requires an argument");
+}
+
+TEST_F(TEST_FIXTURE, ContextsShouldParseConcurrently)
+{
+    std::vector<std::thread> workers;
+    std::vector<int> results(8, 0);
+    for (int t = 0; t < (int)results.size(); t++)
+    {
+        workers.emplace_back([t, &results]()
+        {
+            char buffer[BUFFER_SIZE];
+            char* argv[ARGV_SIZE];
+            ARG_DATA_HANDLE handle = argsparse_ctx_create("worker");
+            argsparse_ctx_add_int(handle, "integer", "This is an integer", 0);
+            for (int i = 0; i < 1000; i++)
+            {
+                sprintf(buffer, "program --integer=%d", t * 1000 + i);
+                // strtok of tokenise_to_argc_argv is not reentrant
+                int argc = argsparse_tokenize(buffer, argv, ARGV_SIZE);
+                argsparse_ctx_parse_args(handle, argv, argc);
+                if (argsparse_ctx_argument_by_name(handle, "integer")->value.intvalue == t * 1000 + i)
+                    results[t]++;
+            }
+            argsparse_ctx_free(handle);
+        });
+    }
+    for (auto& worker : workers)
+        worker.join();
+    for (int result : results)
+        ASSERT_EQ(1000, result);
+}
+
+TEST_F(TEST_FIXTURE, FrozenSchemaShouldParseRepeatedly)
+{
+    int flgValue = 0;
+    assert_create_arguments();
+    argsparse_add_int("integer", "This is an integer", 1234);
+    argsparse_add_cstr("string", "This is a string", "default");
+    argsparse_add_flag("flag", "This is a flag", 1, &flgValue);
+    ASSERT_EQ(ERROR_AP_NONE, argsparse_freeze());
+    ASSERT_EQ(ERROR_AP_NONE, argsparse_freeze());
+    ASSERT_EQ(ERROR_AP_FROZEN, argsparse_add_int("late", "This is an integer", 0));
+    ASSERT_THAT(argsparse_argument_by_name("late"), IsNull());
+    ASSERT_EQ(argsparse_argument_by_name("integer"), argsparse_argument_by_short_name('i'));
+
+    for (int i = 0; i < 3; i++)
+    {
+        sprintf(gBuffer, "program --int=%d -snew --flag", i);
+        tokenise_to_argc_argv(gBuffer, &gArgc, gArgv, ARGV_SIZE, print_arguments);
+        ASSERT_EQ(3, argsparse_parse_args(gArgv, gArgc));
+        ASSERT_EQ(i, argsparse_argument_by_name("integer")->value.intvalue);
+        ASSERT_STREQ("new", argsparse_argument_by_name("string")->value.stringvalue);
+        ASSERT_EQ(1, flgValue);
+
+        argsparse_reset();
+        ASSERT_EQ(1234, argsparse_argument_by_name("integer")->value.intvalue);
+        ASSERT_STREQ("default", argsparse_argument_by_name("string")->value.stringvalue);
+        ASSERT_EQ(0, argsparse_argument_by_name("integer")->parsed);
+        ASSERT_EQ(0, flgValue);
+    }
+}
+
+TEST_F(TEST_FIXTURE, ShouldNotTruncateLongStrings)
+{
+    std::string description(3 * ARGSPARSE_MAX_STRING_SIZE, 'd');
+    std::string value(3 * ARGSPARSE_MAX_STRING_SIZE, 'v');
+    std::string option = "--string=" + value;
+    char* argv[] = { (char*)"program", option.data() };
+
+    assert_create_arguments();
+    ASSERT_EQ(ERROR_AP_NONE, argsparse_add_cstr("string", description.c_str(), "default"));
+    ARG_ARGUMENT_HANDLE arg = argsparse_argument_by_name("string");
+    ASSERT_EQ(description, arg->description);
+    ASSERT_EQ(1, argsparse_parse_args(argv, 2));
+    ASSERT_EQ(value, arg->value.stringvalue);
+
+    // nor when shown
+    ::testing::internal::CaptureStdout();
+    argsparse_show_usage("program");
+    argsparse_show_arguments();
+    std::string output = ::testing::internal::GetCapturedStdout();
+    EXPECT_NE(std::string::npos, output.find("    desc: " + description + "\n"));
+    EXPECT_NE(std::string::npos, output.find("    args: [str:" + value + "]\n"));
+    EXPECT_NE(std::string::npos, output.find("[str] " + value + "\n"));
+}
+
+TEST_F(TEST_FIXTURE, ShouldReferenceArgvStrings)
+{
+    sprintf(gBuffer, "program --string value");
+    tokenise_to_argc_argv(gBuffer, &gArgc, gArgv, ARGV_SIZE, print_arguments);
+
+    assert_create_arguments();
+    argsparse_add_cstr("string", "This is a string", "default");
+    ASSERT_EQ(1, argsparse_parse_args(gArgv, gArgc));
+    ASSERT_EQ(gArgv[2], argsparse_argument_by_name("string")->value.stringvalue);
+}
+
+TEST_F(TEST_FIXTURE, ShouldCopyStringsWhenRequested)
+{
+    sprintf(gBuffer, "program --string value");
+    tokenise_to_argc_argv(gBuffer, &gArgc, gArgv, ARGV_SIZE, print_arguments);
+
+    assert_create_arguments();
+    argsparse_set_flags(ARGSPARSE_FLAG_COPY_STRINGS);
+    ASSERT_EQ(ARGSPARSE_FLAG_COPY_STRINGS, argsparse_get_flags());
+    argsparse_add_cstr("string", "This is a string", "default");
+    ASSERT_EQ(1, argsparse_parse_args(gArgv, gArgc));
+    memset(gBuffer, 0, sizeof(gBuffer));
+    ASSERT_STREQ("value", argsparse_argument_by_name("string")->value.stringvalue);
+}
+
+TEST_F(TEST_FIXTURE, CopiedStringsShouldReuseStorage)
+{
+    assert_create_arguments();
+    argsparse_set_flags(ARGSPARSE_FLAG_COPY_STRINGS);
+    argsparse_add_cstr("string", "This is a string", "default");
+    ASSERT_EQ(ERROR_AP_NONE, argsparse_freeze());
+    ARG_ARGUMENT_HANDLE string = argsparse_argument_by_name("string");
+
+    const char* copy = nullptr;
+    size_t copy_size = 0;
+    for (int i = 0; i < 10000; i++)
+    {
+        sprintf(gBuffer, "program --string=value%06d", i);
+        tokenise_to_argc_argv(gBuffer, &gArgc, gArgv, ARGV_SIZE, print_arguments);
+        ASSERT_EQ(1, argsparse_parse_args(gArgv, gArgc));
+        ASSERT_STREQ(gArgv[1] + strlen("--string="), string->value.stringvalue);
+        if (i == 0)
+        {
+            copy = string->copy;
+            copy_size = string->copy_size;
+        }
+        // every distinct value lands in the same storage
+        ASSERT_EQ(copy, string->value.stringvalue);
+        ASSERT_EQ(copy_size, string->copy_size);
+        argsparse_reset();
+        ASSERT_STREQ("default", string->value.stringvalue);
+    }
+}
+
+TEST_F(TEST_FIXTURE, ShouldRejectInvalidNumbers)
+{
+    assert_create_arguments();
+    argsparse_add_int("integer", "This is an integer", 1234);
+    argsparse_add_double("double", "This is a double", 1234.4321);
+    ARG_ARGUMENT_HANDLE integer = argsparse_argument_by_name("integer");
+    ARG_ARGUMENT_HANDLE dbl = argsparse_argument_by_name("double");
+
+    const std::pair<const char*, int> cases[] = {
+        { "program --integer=12abc", ERROR_AP_FORMAT },
+        { "program --integer=", ERROR_AP_FORMAT },
+        { "program --integer=2147483648", ERROR_AP_RANGE },
+        { "program --double=1.5x", ERROR_AP_FORMAT },
+        { "program --double=1,5", ERROR_AP_FORMAT },
+        { "program --double=1e400", ERROR_AP_RANGE },
+    };
+    for (const auto& test : cases)
+    {
+        strcpy(gBuffer, test.first);
+        tokenise_to_argc_argv(gBuffer, &gArgc, gArgv, ARGV_SIZE, print_arguments);
+        ASSERT_EQ(test.second, argsparse_parse_args(gArgv, gArgc)) << test.first;
+    }
+    ASSERT_EQ(0, integer->parsed);
+    ASSERT_EQ(1234, integer->value.intvalue);
+    ASSERT_EQ(0, dbl->parsed);
+
+    sprintf(gBuffer, "program --integer=-2147483648 --double=-0.1e-3");
+    tokenise_to_argc_argv(gBuffer, &gArgc, gArgv, ARGV_SIZE, print_arguments);
+    ASSERT_EQ(2, argsparse_parse_args(gArgv, gArgc));
+    ASSERT_EQ(INT_MIN, integer->value.intvalue);
+    ASSERT_EQ(-0.1e-3, dbl->value.doublevalue);
+}
+
 TEST_F(TEST_FIXTURE, UsageOutput)
 {
     const char* const executable = "\\some\\path\\test.exe";
@@ -431,6 +746,691 @@ TEST_F(TEST_FIXTURE, UsageOutput)
     ASSERT_STREQ(expected, output.c_str());
 }
 
+static std::string write_response_file(const char* name, const char* contents)
+{
+    std::string path = ::testing::TempDir() + name;
+    std::ofstream(path, std::ios::binary) << contents;
+    return path;
+}
+
+struct SinkWrites
+{
+    int count = 0;
+    std::string text;
+    int stream = 0;
+};
+
+static void collect_output(void* context, int stream, const char* text, size_t length)
+{
+    SinkWrites* writes = static_cast<SinkWrites*>(context);
+    writes->count++;
+    writes->stream = stream;
+    writes->text.append(text, length);
+}
+
+TEST_F(TEST_FIXTURE, ShouldWriteUsageToSinkOnce)
+{
+    SinkWrites writes;
+    char buffer[256];
+    assert_create_arguments("Title");
+    argsparse_set_output(collect_output, &writes, buffer, sizeof(buffer));
+    argsparse_add_cstr("string", "This is a string", "defvalue");
+    argsparse_add_int("integer", "This is an integer", 1);
+
+    argsparse_show_usage("test");
+    EXPECT_EQ(1, writes.count);
+    EXPECT_EQ(ARGSPARSE_STREAM_OUT, writes.stream);
+    EXPECT_EQ(0u, writes.text.find("usage: test [-s] [-i]\ntitle: Title\n"));
+
+    // larger than the buffer, flushed in chunks
+    writes = SinkWrites();
+    for (int i = 0; i < 10; i++)
+    {
+        argsparse_add_int(("integer" + std::to_string(i)).c_str(), "This is an integer", i);
+    }
+    argsparse_show_arguments();
+    EXPECT_GT(writes.count, 1);
+    EXPECT_NE(std::string::npos, writes.text.find("integer9: [int] 9\n"));
+}
+
+TEST_F(TEST_FIXTURE, QuietParseShouldNotWrite)
+{
+    SinkWrites writes;
+    sprintf(gBuffer, "program --integer=1 --flag operand");
+    tokenise_to_argc_argv(gBuffer, &gArgc, gArgv, ARGV_SIZE, print_arguments);
+
+    int flag = 0;
+    assert_create_arguments();
+    argsparse_set_output(collect_output, &writes, NULL, 0);
+    argsparse_add_int("integer", "This is an integer", 0);
+    argsparse_add_flag("flag", "This is a flag", 1, &flag);
+
+    ASSERT_EQ(2, argsparse_parse_args(gArgv, gArgc));
+    EXPECT_EQ(1, writes.count);
+    EXPECT_EQ("option -i\nparsed 1\nflag --flag\nnon-option ARGV-elements: operand \n", writes.text);
+
+    writes = SinkWrites();
+    argsparse_set_flags(ARGSPARSE_FLAG_QUIET);
+    ASSERT_EQ(2, argsparse_parse_args(gArgv, gArgc));
+    sprintf(gBuffer, "program --integer=x");
+    tokenise_to_argc_argv(gBuffer, &gArgc, gArgv, ARGV_SIZE, print_arguments);
+    ASSERT_EQ(ERROR_AP_FORMAT, argsparse_parse_args(gArgv, gArgc));
+    EXPECT_EQ(0, writes.count);
+}
+
+TEST_F(TEST_FIXTURE, FrozenShouldMatchUniquePrefixes)
+{
+    assert_create_arguments();
+    argsparse_add_int("in", "Exact name and prefix of others", 0);
+    argsparse_add_int("integer", "This is an integer", 0);
+    argsparse_add_int("interval", "This is an integer", 0);
+    argsparse_add_cstr("string", "This is a string", "default");
+    char name[16];
+    for (int i = 0; i < 1000; i++)
+    {
+        sprintf(name, "option%d", i);
+        ASSERT_EQ(ERROR_AP_NONE, argsparse_add_int(name, "generated", 0));
+    }
+    ASSERT_EQ(ERROR_AP_NONE, argsparse_freeze());
+
+    sprintf(gBuffer, "program --in=1 --integ=2 --interv 3 --str=s --option999=4 --option12=5");
+    tokenise_to_argc_argv(gBuffer, &gArgc, gArgv, ARGV_SIZE, print_arguments);
+    ASSERT_EQ(6, argsparse_parse_args(gArgv, gArgc));
+    EXPECT_EQ(1, argsparse_argument_by_name("in")->value.intvalue);
+    EXPECT_EQ(2, argsparse_argument_by_name("integer")->value.intvalue);
+    EXPECT_EQ(3, argsparse_argument_by_name("interval")->value.intvalue);
+    EXPECT_STREQ("s", argsparse_argument_by_name("string")->value.stringvalue);
+    EXPECT_EQ(4, argsparse_argument_by_name("option999")->value.intvalue);
+    EXPECT_EQ(5, argsparse_argument_by_name("option12")->value.intvalue);
+
+    sprintf(gBuffer, "program --optionx=1");
+    tokenise_to_argc_argv(gBuffer, &gArgc, gArgv, ARGV_SIZE, print_arguments);
+    ASSERT_EXIT(argsparse_parse_args(gArgv, gArgc), ::testing::ExitedWithCode(1), "unrecognized option '--optionx=1'");
+
+    // every name sharing the prefix is listed
+    sprintf(gBuffer, "program --inte=1");
+    tokenise_to_argc_argv(gBuffer, &gArgc, gArgv, ARGV_SIZE, print_arguments);
+    ASSERT_EXIT(argsparse_parse_args(gArgv, gArgc), ::testing::ExitedWithCode(1),
+        "option '--inte' is ambiguous; possibilities: '--integer' '--interval'");
+}
+
+TEST_F(TEST_FIXTURE, ShouldAccessValuesById)
+{
+    sprintf(gBuffer, "program --integer=3 --double=1.5 --flag");
+    tokenise_to_argc_argv(gBuffer, &gArgc, gArgv, ARGV_SIZE, print_arguments);
+
+    assert_create_arguments();
+    ASSERT_EQ(0, argsparse_add_help());
+    int integer = argsparse_add_int_id("integer", "This is an integer", 5);
+    int dbl = argsparse_add_double_id("double", "This is a double", 0.5);
+    int string = argsparse_add_cstr_id("string", "This is a string", "default");
+    int flag = argsparse_add_flag_id("flag", "This is a flag", 7, nullptr);
+    EXPECT_EQ(1, integer);
+    EXPECT_EQ(4, flag);
+    EXPECT_EQ(ERROR_AP_EXISTS, argsparse_add_int_id("integer", "Again", 0));
+    EXPECT_EQ(dbl, argsparse_argument_id("double"));
+    EXPECT_EQ(ERROR_AP_UNKNOWN, argsparse_argument_id("missing"));
+
+    ASSERT_EQ(3, argsparse_parse_args(gArgv, gArgc));
+    EXPECT_EQ(3, argsparse_get_int(integer));
+    EXPECT_DOUBLE_EQ(1.5, argsparse_get_double(dbl));
+    EXPECT_STREQ("default", argsparse_get_cstr(string));
+    EXPECT_EQ(7, argsparse_get_flag(flag));
+    EXPECT_EQ(ARGSPARSE_SOURCE_CMDLINE, argsparse_is_parsed(integer));
+    EXPECT_EQ(0, argsparse_is_parsed(string));
+
+    // wrong type or out of range
+    EXPECT_EQ(0, argsparse_get_int(dbl));
+    EXPECT_THAT(argsparse_get_cstr(integer), IsNull());
+    EXPECT_EQ(0, argsparse_is_parsed(-1));
+    EXPECT_EQ(0, argsparse_is_parsed(5));
+}
+
+TEST_F(TEST_FIXTURE, LazyParseShouldConvertOnLookup)
+{
+    SinkWrites writes;
+    sprintf(gBuffer, "program --integer=12 --double=x -s text");
+    tokenise_to_argc_argv(gBuffer, &gArgc, gArgv, ARGV_SIZE, print_arguments);
+
+    assert_create_arguments();
+    argsparse_set_output(collect_output, &writes, NULL, 0);
+    argsparse_add_int("integer", "This is an integer", 5);
+    argsparse_add_double("double", "This is a double", 0.5);
+    argsparse_add_cstr("string", "This is a string", "default");
+    argsparse_set_flags(ARGSPARSE_FLAG_LAZY);
+
+    // the invalid double is not looked at yet
+    ASSERT_EQ(3, argsparse_parse_args(gArgv, gArgc));
+    writes = SinkWrites();
+
+    ARG_ARGUMENT_HANDLE integer = argsparse_argument_by_name("integer");
+    EXPECT_EQ(12, integer->value.intvalue);
+    EXPECT_EQ(ARGSPARSE_SOURCE_CMDLINE, integer->parsed);
+    EXPECT_THAT(integer->raw, IsNull());
+    EXPECT_STREQ("text", argsparse_argument_by_short_name('s')->value.stringvalue);
+    EXPECT_EQ(0, writes.count);
+
+    // reported on the first lookup only, the default stays
+    ARG_ARGUMENT_HANDLE dbl = argsparse_argument_by_name("double");
+    EXPECT_DOUBLE_EQ(0.5, dbl->value.doublevalue);
+    EXPECT_EQ(ARGSPARSE_SOURCE_DEFAULT, dbl->parsed);
+    EXPECT_EQ(ARGSPARSE_STREAM_ERR, writes.stream);
+    EXPECT_EQ("invalid value 'x' for option '--double'\n", writes.text);
+    argsparse_argument_by_name("double");
+    EXPECT_EQ(1, writes.count);
+
+    // accessors by id convert too
+    sprintf(gBuffer, "program --integer=21");
+    tokenise_to_argc_argv(gBuffer, &gArgc, gArgv, ARGV_SIZE, print_arguments);
+    ASSERT_EQ(1, argsparse_parse_args(gArgv, gArgc));
+    EXPECT_EQ(21, argsparse_get_int(argsparse_argument_id("integer")));
+}
+
+TEST_F(TEST_FIXTURE, ShouldExpandResponseFiles)
+{
+    std::string nested = write_response_file("argsparse_nested.rsp", "--double=2.5\n");
+    std::string outer = write_response_file("argsparse_outer.rsp",
+        ("--integer 42\n--string \"quoted \\\"value\\\"\" @" + nested + " 'x y'").c_str());
+    std::string argument = "@" + outer;
+    std::string missing = "@" + ::testing::TempDir() + "argsparse_missing.rsp";
+    char program[] = "program";
+    char* argv[] = { program, &argument[0], &missing[0] };
+
+    SinkWrites writes;
+    assert_create_arguments();
+    argsparse_set_output(collect_output, &writes, NULL, 0);
+    argsparse_add_int("integer", "This is an integer", 0);
+    argsparse_add_double("double", "This is a double", 0);
+    argsparse_add_cstr("string", "This is a string", "default");
+
+    ASSERT_EQ(3, argsparse_parse_args(argv, 3));
+    EXPECT_EQ(42, argsparse_argument_by_name("integer")->value.intvalue);
+    EXPECT_EQ(2.5, argsparse_argument_by_name("double")->value.doublevalue);
+    EXPECT_STREQ("quoted \"value\"", argsparse_argument_by_name("string")->value.stringvalue);
+    // unreadable response files are operands
+    EXPECT_NE(std::string::npos, writes.text.find("non-option ARGV-elements: x y " + missing + " \n"));
+}
+
+static int count_maps(const file_map_t* list)
+{
+    int count = 0;
+    for (; list; list = list->next)
+        count++;
+    return count;
+}
+
+TEST_F(TEST_FIXTURE, RepeatedParsesShouldReleaseResponseFiles)
+{
+    std::string path = write_response_file("argsparse_repeat.rsp", "--string=file --integer=3");
+    std::string argument = "@" + path;
+    char program[] = "program";
+    char other[] = "--integer=4";
+    char* argv[] = { program, &argument[0] };
+
+    ARG_DATA_HANDLE handle = argsparse_ctx_create("repeat");
+    argsparse_ctx_set_flags(handle, ARGSPARSE_FLAG_QUIET);
+    argsparse_ctx_add_int(handle, "integer", "This is an integer", 0);
+    argsparse_ctx_add_cstr(handle, "string", "This is a string", "default");
+    ASSERT_EQ(ERROR_AP_NONE, argsparse_ctx_freeze(handle));
+    for (int i = 0; i < 1000; i++)
+    {
+        argsparse_ctx_reset(handle);
+        ASSERT_EQ(2, argsparse_ctx_parse_args(handle, argv, 2));
+        ASSERT_EQ(1, count_maps(handle->parse_files) + count_maps(handle->files));
+    }
+
+    // the next parse closes the file, the value read from it stays
+    argv[1] = other;
+    ASSERT_EQ(1, argsparse_ctx_parse_args(handle, argv, 2));
+    EXPECT_THAT(handle->parse_files, IsNull());
+    EXPECT_STREQ("file", argsparse_ctx_argument_by_name(handle, "string")->value.stringvalue);
+    EXPECT_EQ(4, argsparse_ctx_argument_by_name(handle, "integer")->value.intvalue);
+
+    argsparse_ctx_reset(handle);
+    EXPECT_STREQ("default", argsparse_ctx_argument_by_name(handle, "string")->value.stringvalue);
+    argsparse_ctx_free(handle);
+}
+
+TEST_F(TEST_FIXTURE, ExitWhenResponseFilesNestTooDeeply)
+{
+    std::string path = ::testing::TempDir() + "argsparse_recursive.rsp";
+    write_response_file("argsparse_recursive.rsp", ("@" + path).c_str());
+    std::string argument = "@" + path;
+    char program[] = "program";
+    char* argv[] = { program, &argument[0] };
+
+    assert_create_arguments();
+    ASSERT_EXIT(argsparse_parse_args(argv, 2), ::testing::ExitedWithCode(1), "nested too deeply");
+}
+
+TEST_F(TEST_FIXTURE, ShouldLoadConfigBelowCommandLine)
+{
+    std::string path = write_response_file("argsparse_config.ini",
+        "# comment\r\n"
+        "[section]\n"
+        "  integer = 42  \n"
+        "; comment\n"
+        "double=2.5\n"
+        "string = \" spaced value \"\n"
+        "flag\n"
+        "other = off");
+    sprintf(gBuffer, "program --integer 7");
+    tokenise_to_argc_argv(gBuffer, &gArgc, gArgv, ARGV_SIZE, print_arguments);
+
+    int flag = 0;
+    int other = 0;
+    assert_create_arguments();
+    argsparse_add_int("integer", "This is an integer", 0);
+    argsparse_add_double("double", "This is a double", 0);
+    argsparse_add_cstr("string", "This is a string", "default");
+    argsparse_add_flag("flag", "This is a flag", 3, &flag);
+    argsparse_add_flag("other", "This is a flag", 3, &other);
+
+    ASSERT_EQ(1, argsparse_parse_args(gArgv, gArgc));
+    ASSERT_EQ(3, argsparse_load_config(path.c_str()));
+    EXPECT_EQ(7, argsparse_argument_by_name("integer")->value.intvalue);
+    EXPECT_EQ(ARGSPARSE_SOURCE_CMDLINE, argsparse_argument_by_name("integer")->parsed);
+    EXPECT_EQ(2.5, argsparse_argument_by_name("double")->value.doublevalue);
+    EXPECT_EQ(ARGSPARSE_SOURCE_CONFIG, argsparse_argument_by_name("double")->parsed);
+    EXPECT_STREQ(" spaced value ", argsparse_argument_by_name("string")->value.stringvalue);
+    EXPECT_EQ(3, flag);
+    EXPECT_EQ(0, other);
+    EXPECT_EQ(ARGSPARSE_SOURCE_DEFAULT, argsparse_argument_by_name("other")->parsed);
+
+    // command line parsed afterwards still wins
+    ASSERT_EQ(1, argsparse_parse_args(gArgv, gArgc));
+    EXPECT_EQ(7, argsparse_argument_by_name("integer")->value.intvalue);
+}
+
+TEST_F(TEST_FIXTURE, LazyFormatErrorShouldKeepConfigSource)
+{
+    std::string path = write_response_file("argsparse_lazy.ini", "double = 2.5\nstring = config");
+    sprintf(gBuffer, "program --double=x --string=text");
+    tokenise_to_argc_argv(gBuffer, &gArgc, gArgv, ARGV_SIZE, print_arguments);
+
+    assert_create_arguments();
+    argsparse_add_double("double", "This is a double", 0.5);
+    argsparse_add_cstr("string", "This is a string", "default");
+    argsparse_set_flags(ARGSPARSE_FLAG_QUIET | ARGSPARSE_FLAG_COPY_STRINGS | ARGSPARSE_FLAG_LAZY);
+    ASSERT_EQ(2, argsparse_load_config(path.c_str()));
+
+    ASSERT_EQ(2, argsparse_parse_args(gArgv, gArgc));
+    // the option text was copied, argv is not needed for the lookups
+    memset(gBuffer, 0, sizeof(gBuffer));
+
+    ARG_ARGUMENT_HANDLE dbl = argsparse_argument_by_name("double");
+    EXPECT_EQ(2.5, dbl->value.doublevalue);
+    EXPECT_EQ(ARGSPARSE_SOURCE_CONFIG, dbl->parsed);
+    ARG_ARGUMENT_HANDLE string = argsparse_argument_by_name("string");
+    EXPECT_STREQ("text", string->value.stringvalue);
+    EXPECT_EQ(ARGSPARSE_SOURCE_CMDLINE, string->parsed);
+}
+
+TEST_F(TEST_FIXTURE, ReloadedConfigShouldReleaseItsFile)
+{
+    std::string first = write_response_file("argsparse_first.ini", "string = first\n");
+    std::string second = write_response_file("argsparse_second.ini", "integer = 2\n");
+
+    ARG_DATA_HANDLE handle = argsparse_ctx_create("reload");
+    argsparse_ctx_add_int(handle, "integer", "This is an integer", 0);
+    argsparse_ctx_add_cstr(handle, "string", "This is a string", "default");
+    for (int i = 0; i < 1000; i++)
+    {
+        ASSERT_EQ(1, argsparse_ctx_load_config(handle, first.c_str()));
+        ASSERT_EQ(1, count_maps(handle->config_files) + count_maps(handle->files));
+    }
+
+    // the value of the released file stays
+    ASSERT_EQ(1, argsparse_ctx_load_config(handle, second.c_str()));
+    EXPECT_STREQ("first", argsparse_ctx_argument_by_name(handle, "string")->value.stringvalue);
+    EXPECT_EQ(2, argsparse_ctx_argument_by_name(handle, "integer")->value.intvalue);
+    argsparse_ctx_free(handle);
+}
+
+TEST_F(TEST_FIXTURE, ShouldReportConfigErrors)
+{
+    SinkWrites writes;
+    assert_create_arguments();
+    argsparse_set_output(collect_output, &writes, NULL, 0);
+    argsparse_add_int("integer", "This is an integer", 0);
+
+    std::string unknown = write_response_file("argsparse_unknown.ini", "integer = 1\nunknown = 2\n");
+    std::string invalid = write_response_file("argsparse_invalid.ini", "\ninteger = 1x\n");
+    std::string range = write_response_file("argsparse_range.ini", "integer = 99999999999\n");
+    EXPECT_EQ(ERROR_AP_UNKNOWN, argsparse_load_config(unknown.c_str()));
+    EXPECT_NE(std::string::npos, writes.text.find(unknown + ":2: unknown option 'unknown'"));
+    // the lines before the bad one stay applied
+    EXPECT_EQ(1, argsparse_argument_by_name("integer")->value.intvalue);
+    EXPECT_EQ(ARGSPARSE_SOURCE_CONFIG, argsparse_argument_by_name("integer")->parsed);
+    EXPECT_EQ(ERROR_AP_FORMAT, argsparse_load_config(invalid.c_str()));
+    EXPECT_NE(std::string::npos, writes.text.find(invalid + ":2: invalid value '1x' for option 'integer'"));
+    EXPECT_EQ(ERROR_AP_RANGE, argsparse_load_config(range.c_str()));
+    EXPECT_EQ(ERROR_AP_FILE, argsparse_load_config((::testing::TempDir() + "argsparse_missing.ini").c_str()));
+}
+
+TEST_F(TEST_FIXTURE, ShouldLoadEnvironmentBelowCommandLine)
+{
+    std::string path = write_response_file("argsparse_env.ini", "double = 1.5\nstring = config\n");
+    char threads[] = "APP_THREADS=8";
+    char cache[] = "APP_CACHE_MB=64";
+    char dbl[] = "APP_DOUBLE=2.5";
+    char bound[] = "SERVICE_NAME=env";
+    char ignored[] = "APP_STRING=ignored";
+    char flag_set[] = "APP_FLAG=yes";
+    char unrelated[] = "PATH=/bin";
+    char* envp[] = { threads, cache, dbl, bound, ignored, flag_set, unrelated, nullptr };
+    sprintf(gBuffer, "program --threads 2");
+    tokenise_to_argc_argv(gBuffer, &gArgc, gArgv, ARGV_SIZE, print_arguments);
+
+    int flag = 0;
+    assert_create_arguments();
+    argsparse_add_int("threads", "This is an integer", 1);
+    argsparse_add_int("cache-mb", "This is an integer", 0);
+    argsparse_add_double("double", "This is a double", 0);
+    argsparse_add_cstr("string", "This is a string", "default");
+    argsparse_add_flag("flag", "This is a flag", 1, &flag);
+    argsparse_set_env_prefix("APP_");
+    ASSERT_EQ(ERROR_AP_NONE, argsparse_bind_env("string", "SERVICE_NAME"));
+    ASSERT_EQ(ERROR_AP_UNKNOWN, argsparse_bind_env("unknown", "SERVICE_NAME"));
+
+    ASSERT_EQ(1, argsparse_parse_args(gArgv, gArgc));
+    ASSERT_EQ(4, argsparse_load_env(envp));
+    ASSERT_EQ(0, argsparse_load_config(path.c_str()));
+    EXPECT_EQ(2, argsparse_argument_by_name("threads")->value.intvalue);
+    EXPECT_EQ(64, argsparse_argument_by_name("cache-mb")->value.intvalue);
+    EXPECT_EQ(ARGSPARSE_SOURCE_ENV, argsparse_argument_by_name("cache-mb")->parsed);
+    EXPECT_EQ(2.5, argsparse_argument_by_name("double")->value.doublevalue);
+    EXPECT_STREQ("env", argsparse_argument_by_name("string")->value.stringvalue);
+    EXPECT_EQ(1, flag);
+
+#if !defined(_WIN32)
+    setenv("APP_CACHE_MB", "128", 1);
+    EXPECT_GE(argsparse_load_env(nullptr), 1);
+    EXPECT_EQ(128, argsparse_argument_by_name("cache-mb")->value.intvalue);
+    unsetenv("APP_CACHE_MB");
+#endif
+
+    char invalid[] = "APP_CACHE_MB=lots";
+    char* invalid_envp[] = { invalid, nullptr };
+    argsparse_set_flags(ARGSPARSE_FLAG_QUIET);
+    EXPECT_EQ(ERROR_AP_FORMAT, argsparse_load_env(invalid_envp));
+}
+
+TEST_F(TEST_FIXTURE, ShouldParseBatchIntoSeparateResults)
+{
+    const int count = 1000;
+    std::vector<std::vector<std::string>> tokens(count);
+    std::vector<std::vector<char*>> argvs(count);
+    std::vector<char* const*> argv_list(count);
+    for (int i = 0; i < count; i++)
+    {
+        tokens[i] = { "program", "--integer=" + std::to_string(i), "-s", "value" + std::to_string(i) };
+        if (i % 2)
+            tokens[i].push_back("--flag");
+        if (i % 100 == 99)
+            tokens[i].push_back("--unknown");
+        for (auto& token : tokens[i])
+            argvs[i].push_back(&token[0]);
+        argvs[i].push_back(nullptr);
+        argv_list[i] = argvs[i].data();
+    }
+
+    int flag = 0;
+    ARG_DATA_HANDLE handle = argsparse_ctx_create("batch");
+    ASSERT_THAT(handle, NotNull());
+    argsparse_ctx_add_int(handle, "integer", "This is an integer", -1);
+    argsparse_ctx_add_double(handle, "double", "This is a double", 0.5);
+    argsparse_ctx_add_cstr(handle, "string", "This is a string", "default");
+    argsparse_ctx_add_flag(handle, "flag", "This is a flag", 7, &flag);
+
+    std::vector<ARG_RESULT_HANDLE> results(count);
+    ASSERT_EQ(count - count / 100, argsparse_ctx_parse_batch(handle, argv_list.data(), count, results.data(), 4));
+    for (int i = 0; i < count; i++)
+    {
+        ARG_RESULT_HANDLE result = results[i];
+        ASSERT_THAT(result, NotNull());
+        if (i % 100 == 99)
+        {
+            EXPECT_EQ(ERROR_AP_UNKNOWN, argsparse_result_status(result));
+            continue;
+        }
+        EXPECT_EQ(2 + i % 2, argsparse_result_status(result));
+        EXPECT_EQ(i, argsparse_result_value(result, "integer")->intvalue);
+        EXPECT_EQ(0.5, argsparse_result_value(result, "double")->doublevalue);
+        EXPECT_EQ(argvs[i][3], argsparse_result_value(result, "string")->stringvalue);
+        EXPECT_EQ(i % 2 ? 7 : 0, argsparse_result_value(result, "flag")->intvalue);
+        EXPECT_EQ(1, argsparse_result_parsed(result, "integer"));
+        EXPECT_EQ(0, argsparse_result_parsed(result, "double"));
+    }
+    EXPECT_THAT(argsparse_result_value(results[0], "unknown"), IsNull());
+
+    // the schema itself is untouched
+    EXPECT_EQ(-1, argsparse_ctx_argument_by_name(handle, "integer")->value.intvalue);
+    EXPECT_EQ(0, argsparse_ctx_argument_by_name(handle, "integer")->parsed);
+    EXPECT_EQ(0, flag);
+
+    for (ARG_RESULT_HANDLE result : results)
+        argsparse_result_free(result);
+    argsparse_ctx_free(handle);
+}
+
+TEST_F(TEST_FIXTURE, ResultsShouldShareTheSchema)
+{
+    sprintf(gBuffer, "program --integer=1 --flag");
+    tokenise_to_argc_argv(gBuffer, &gArgc, gArgv, ARGV_SIZE, print_arguments);
+    char second_buffer[BUFFER_SIZE] = "program -s text";
+    char* second_argv[ARGV_SIZE] = { nullptr, };
+    int second_argc = 0;
+    tokenise_to_argc_argv(second_buffer, &second_argc, second_argv, ARGV_SIZE, print_arguments);
+
+    int flag = 0;
+    assert_create_arguments();
+    argsparse_add_int("integer", "This is an integer", 5);
+    argsparse_add_cstr("string", "This is a string", "default");
+    argsparse_add_flag("flag", "This is a flag", 1, &flag);
+
+    ARG_RESULT_HANDLE first = argsparse_result_create();
+    ARG_RESULT_HANDLE second = argsparse_result_create();
+    ASSERT_THAT(first, NotNull());
+    ASSERT_THAT(second, NotNull());
+    ASSERT_EQ(3, argsparse_result_count(first));
+
+    ASSERT_EQ(2, argsparse_result_parse(first, gArgv, gArgc));
+    ASSERT_EQ(1, argsparse_result_parse(second, second_argv, second_argc));
+    EXPECT_EQ(1, argsparse_result_value_at(first, 0)->intvalue);
+    EXPECT_EQ(1, argsparse_result_value_at(first, 2)->intvalue);
+    EXPECT_STREQ("default", argsparse_result_value_at(first, 1)->stringvalue);
+    EXPECT_EQ(5, argsparse_result_value_at(second, 0)->intvalue);
+    EXPECT_STREQ("text", argsparse_result_value_at(second, 1)->stringvalue);
+    EXPECT_EQ(1, argsparse_result_parsed_at(first, 2));
+    EXPECT_EQ(0, argsparse_result_parsed_at(second, 2));
+    EXPECT_THAT(argsparse_result_value_at(first, 3), IsNull());
+
+    // parsing again starts from the defaults
+    ASSERT_EQ(1, argsparse_result_parse(first, second_argv, second_argc));
+    EXPECT_EQ(5, argsparse_result_value_at(first, 0)->intvalue);
+    EXPECT_EQ(0, argsparse_result_parsed_at(first, 0));
+
+    // the arguments keep their defaults
+    EXPECT_EQ(5, argsparse_argument_by_name("integer")->value.intvalue);
+    EXPECT_EQ(0, flag);
+    argsparse_result_free(first);
+    argsparse_result_free(second);
+}
+
+TEST_F(TEST_FIXTURE, ShouldRestoreArgumentsFromImage)
+{
+    sprintf(gBuffer, "program --integer=7 -s parsed --flag");
+    tokenise_to_argc_argv(gBuffer, &gArgc, gArgv, ARGV_SIZE, print_arguments);
+
+    int flag = 0;
+    assert_create_arguments();
+    argsparse_add_int("integer", "This is an integer", 5);
+    argsparse_add_double("double", "This is a double", 0.25);
+    argsparse_add_cstr("string", "This is a string", "default");
+    argsparse_add_flag("flag", "This is a flag", 1, &flag);
+    ASSERT_EQ(3, argsparse_parse_args(gArgv, gArgc));
+    int short_double = argsparse_argument_by_name("double")->name_short;
+
+    size_t size = argsparse_serialize(nullptr, 0);
+    ASSERT_GT(size, 0u);
+    std::vector<char> image(size);
+    ASSERT_EQ(size, argsparse_serialize(image.data(), image.size()));
+    argsparse_free();
+
+    ASSERT_EQ(ERROR_AP_NONE, argsparse_deserialize(image.data(), image.size()));
+    EXPECT_EQ(ERROR_AP_EXISTS, argsparse_deserialize(image.data(), image.size()));
+    ASSERT_EQ(4, argsparse_argument_count());
+    ARG_ARGUMENT_HANDLE integer = argsparse_argument_by_name("integer");
+    ARG_ARGUMENT_HANDLE string = argsparse_argument_by_name("string");
+    ARG_ARGUMENT_HANDLE restored_flag = argsparse_argument_by_name("flag");
+    ASSERT_THAT(integer, NotNull());
+    ASSERT_THAT(string, NotNull());
+    ASSERT_THAT(restored_flag, NotNull());
+    EXPECT_EQ(7, integer->value.intvalue);
+    EXPECT_EQ(ARGSPARSE_SOURCE_CMDLINE, integer->parsed);
+    EXPECT_DOUBLE_EQ(0.25, argsparse_argument_by_name("double")->value.doublevalue);
+    EXPECT_EQ(ARGSPARSE_SOURCE_DEFAULT, argsparse_argument_by_name("double")->parsed);
+    EXPECT_EQ(short_double, argsparse_argument_by_name("double")->name_short);
+    // zero-copy
+    EXPECT_STREQ("parsed", string->value.stringvalue);
+    EXPECT_GE(string->value.stringvalue, image.data());
+    EXPECT_LT(string->value.stringvalue, image.data() + image.size());
+    EXPECT_EQ(1, *restored_flag->value.flagptr);
+    EXPECT_STREQ("This is a flag", restored_flag->description);
+    EXPECT_EQ(string, argsparse_argument_by_short_name('s'));
+    argsparse_free();
+
+    // damaged images are rejected
+    image[0] = 'X';
+    EXPECT_EQ(ERROR_AP_FORMAT, argsparse_deserialize(image.data(), image.size()));
+    image[0] = 'A';
+    EXPECT_EQ(ERROR_AP_FORMAT, argsparse_deserialize(image.data(), image.size() - 1));
+}
+
+TEST_F(TEST_FIXTURE, ShouldRestoreArgumentsFromDescriptor)
+{
+    sprintf(gBuffer, "program --string=piped");
+    tokenise_to_argc_argv(gBuffer, &gArgc, gArgv, ARGV_SIZE, print_arguments);
+
+    ARG_DATA_HANDLE handle = argsparse_ctx_create("descriptor");
+    ASSERT_THAT(handle, NotNull());
+    argsparse_ctx_add_cstr(handle, "string", "This is a string", "default");
+    argsparse_ctx_add_int(handle, "integer", "This is an integer", -3);
+    ASSERT_EQ(1, argsparse_ctx_parse_args(handle, gArgv, gArgc));
+
+    FILE* file = tmpfile();
+    ASSERT_THAT(file, NotNull());
+    ASSERT_EQ(ERROR_AP_NONE, argsparse_ctx_serialize_fd(handle, fileno(file)));
+    argsparse_ctx_free(handle);
+
+    ARG_DATA_HANDLE restored = argsparse_ctx_deserialize_fd(fileno(file));
+    fclose(file);
+    ASSERT_THAT(restored, NotNull());
+    EXPECT_STREQ("descriptor", argsparse_ctx_get_title(restored));
+    EXPECT_STREQ("piped", argsparse_ctx_argument_by_name(restored, "string")->value.stringvalue);
+    EXPECT_EQ(-3, argsparse_ctx_argument_by_name(restored, "integer")->value.intvalue);
+
+    // restored handles parse like any other
+    sprintf(gBuffer, "program --integer=4");
+    tokenise_to_argc_argv(gBuffer, &gArgc, gArgv, ARGV_SIZE, print_arguments);
+    EXPECT_EQ(1, argsparse_ctx_parse_args(restored, gArgv, gArgc));
+    EXPECT_EQ(4, argsparse_ctx_argument_by_name(restored, "integer")->value.intvalue);
+    argsparse_ctx_free(restored);
+}
+
+static ARG_ERROR build_cached_schema(ARG_DATA_HANDLE handle, void* context)
+{
+    ++*(int*)context;
+    argsparse_ctx_add_int(handle, "integer", "This is an integer", 5);
+    argsparse_ctx_add_cstr(handle, "string", "This is a string", "default");
+    return argsparse_ctx_add_flag(handle, "flag", "This is a flag", 1, nullptr);
+}
+
+TEST_F(TEST_FIXTURE, ShouldBuildSchemaCacheOnlyOnMiss)
+{
+    std::string path = ::testing::TempDir() + "argsparse_schema.cache";
+    std::remove(path.c_str());
+    int builds = 0;
+
+    ARG_DATA_HANDLE built = argsparse_ctx_create_cached("cached", path.c_str(), 1, build_cached_schema, &builds);
+    ASSERT_THAT(built, NotNull());
+    ASSERT_EQ(1, builds);
+    int short_string = argsparse_ctx_argument_by_name(built, "string")->name_short;
+    argsparse_ctx_free(built);
+
+    ARG_DATA_HANDLE cached = argsparse_ctx_create_cached("cached", path.c_str(), 1, build_cached_schema, &builds);
+    ASSERT_THAT(cached, NotNull());
+    EXPECT_EQ(1, builds);
+    EXPECT_EQ(3, argsparse_ctx_argument_count(cached));
+    EXPECT_STREQ("cached", argsparse_ctx_get_title(cached));
+    EXPECT_EQ(short_string, argsparse_ctx_argument_by_name(cached, "string")->name_short);
+
+    sprintf(gBuffer, "program --integer=2 --flag");
+    tokenise_to_argc_argv(gBuffer, &gArgc, gArgv, ARGV_SIZE, print_arguments);
+    EXPECT_EQ(2, argsparse_ctx_parse_args(cached, gArgv, gArgc));
+    EXPECT_EQ(2, argsparse_ctx_argument_by_name(cached, "integer")->value.intvalue);
+    EXPECT_EQ(1, *argsparse_ctx_argument_by_name(cached, "flag")->value.flagptr);
+    EXPECT_STREQ("default", argsparse_ctx_argument_by_name(cached, "string")->value.stringvalue);
+    // frozen like a built schema
+    EXPECT_EQ(ERROR_AP_FROZEN, argsparse_ctx_add_int(cached, "late", "Added too late", 0));
+    argsparse_ctx_free(cached);
+
+    // another key rebuilds and replaces the cache
+    ARG_DATA_HANDLE rebuilt = argsparse_ctx_create_cached("cached", path.c_str(), 2, build_cached_schema, &builds);
+    ASSERT_THAT(rebuilt, NotNull());
+    EXPECT_EQ(2, builds);
+    argsparse_ctx_free(rebuilt);
+    argsparse_ctx_free(argsparse_ctx_create_cached("cached", path.c_str(), 2, build_cached_schema, &builds));
+    EXPECT_EQ(2, builds);
+
+    // so does a damaged one
+    write_response_file("argsparse_schema.cache", "ARGSCACH\x02");
+    ARG_DATA_HANDLE repaired = argsparse_ctx_create_cached("cached", path.c_str(), 2, build_cached_schema, &builds);
+    ASSERT_THAT(repaired, NotNull());
+    EXPECT_EQ(3, builds);
+    argsparse_ctx_free(repaired);
+    std::remove(path.c_str());
+}
+
+TEST_F(TEST_FIXTURE, ContextsShouldBeIndependent)
+{
+    ARG_DATA_HANDLE first = argsparse_ctx_create("first");
+    ARG_DATA_HANDLE second = argsparse_ctx_create("second");
+    ASSERT_THAT(first, NotNull());
+    ASSERT_THAT(second, NotNull());
+
+    ASSERT_EQ(ERROR_AP_NONE, argsparse_ctx_add_int(first, "integer", "description", 1));
+    ASSERT_EQ(ERROR_AP_NONE, argsparse_ctx_add_int(second, "integer", "description", 2));
+    ASSERT_EQ(ERROR_AP_NONE, argsparse_ctx_add_cstr(second, "string", "description", "value"));
+    ASSERT_STREQ("first", argsparse_ctx_get_title(first));
+    ASSERT_STREQ("i:", argsparse_ctx_get_shortopts(first));
+    ASSERT_STREQ("i:s:", argsparse_ctx_get_shortopts(second));
+    ASSERT_EQ(1, argsparse_ctx_argument_count(first));
+    ASSERT_EQ(2, argsparse_ctx_argument_count(second));
+
+    sprintf(gBuffer, "program --integer 4321");
+    tokenise_to_argc_argv(gBuffer, &gArgc, gArgv, ARGV_SIZE, print_arguments);
+    ASSERT_EQ(1, argsparse_ctx_parse_args(first, gArgv, gArgc));
+    ASSERT_EQ(4321, argsparse_ctx_argument_by_name(first, "integer")->value.intvalue);
+    ASSERT_EQ(2, argsparse_ctx_argument_by_name(second, "integer")->value.intvalue);
+    ASSERT_THAT(argsparse_ctx_argument_by_name(first, "string"), IsNull());
+
+    argsparse_ctx_free(first);
+    argsparse_ctx_free(second);
+}
+
+TEST_F(TEST_FIXTURE, ContextShouldReportNullHandle)
+{
+    ASSERT_EQ(ERROR_AP_HANDLE, argsparse_ctx_add_int(nullptr, "integer", "description", 1));
+    ASSERT_EQ(ERROR_AP_HANDLE, argsparse_ctx_add_help(nullptr));
+    ASSERT_EQ(ERROR_AP_HANDLE, argsparse_ctx_parse_args(nullptr, nullptr, 0));
+    ASSERT_THAT(argsparse_ctx_argument_by_name(nullptr, "integer"), IsNull());
+    ASSERT_THAT(argsparse_ctx_get_shortopts(nullptr), IsNull());
+    ASSERT_EQ(0, argsparse_ctx_argument_count(nullptr));
+    argsparse_ctx_free(nullptr);
+}
+
 // Parametrised test for all types {0,1,2,3}
 
 TEST_P(TEST_FIXTURE, ShouldAddArgument)